@@ -0,0 +1,128 @@
+#include "app_comm.h"
+#include "history_export.h"
+#include "../data/record_codec.h"
+#include "../data/storage.h"
+#include "../windows/history_window.h"
+#include "../debug/trace.h"
+
+static ExportTransport s_transport;
+
+// Phone's watermark after the last completed export, if any this launch
+static uint32_t s_phone_seq;
+static bool s_phone_seq_known = false;
+
+static bool send_export_chunk(uint16_t seq, uint16_t total, uint32_t first_seq,
+                              const uint8_t *payload, uint16_t length) {
+    DictionaryIterator *iter;
+    if (app_message_outbox_begin(&iter) != APP_MSG_OK) {
+        return false;
+    }
+
+    // A chunk missing a tuple must not be counted as sent
+    if (dict_write_int32(iter, MESSAGE_KEY_ExportSeq, seq) != DICT_OK ||
+        dict_write_int32(iter, MESSAGE_KEY_ExportTotal, total) != DICT_OK ||
+        dict_write_uint32(iter, MESSAGE_KEY_ExportFirstSeq, first_seq) != DICT_OK) {
+        return false;
+    }
+    if (length > 0 &&
+        dict_write_data(iter, MESSAGE_KEY_ExportRecords, payload, length) != DICT_OK) {
+        return false;
+    }
+    return app_message_outbox_send() == APP_MSG_OK;
+}
+
+static void export_done(bool success, const ExportStats *stats) {
+    if (success) {
+        s_phone_seq = stats->next_seq;
+        s_phone_seq_known = true;
+    }
+}
+
+// Records from the phone: edits of stored records when ImportFirstSeq is
+// given, otherwise treatments to append. Each message is one batch write.
+static void handle_import(const Tuple *records, const Tuple *first_seq) {
+    int count = records->length / RECORD_ENCODED_SIZE;
+    if (count > APP_COMM_IMPORT_MAX) {
+        count = APP_COMM_IMPORT_MAX;
+    }
+
+    TreatmentRecord *batch = malloc(count * sizeof(TreatmentRecord));
+    if (!batch) {
+        return;
+    }
+    // Stop at a record that does not decode, so edits stay aligned
+    int decoded = 0;
+    while (decoded < count &&
+           record_decode(&records->value->data[decoded * RECORD_ENCODED_SIZE], RECORD_ENCODED_SIZE,
+                         &batch[decoded])) {
+        decoded++;
+    }
+
+    int stored = first_seq ? storage_update_history(first_seq->value->uint32, batch, decoded)
+                           : storage_import_history(batch, decoded);
+    free(batch);
+    APP_LOG(APP_LOG_LEVEL_INFO, "phone %s: %d of %d records stored",
+            first_seq ? "edit" : "import", stored, count);
+    if (stored > 0) {
+        history_window_refresh();
+    }
+}
+
+static void inbox_received_handler(DictionaryIterator *iter, void *context) {
+    Tuple *records = dict_find(iter, MESSAGE_KEY_ImportRecords);
+    if (records) {
+        handle_import(records, dict_find(iter, MESSAGE_KEY_ImportFirstSeq));
+    }
+    if (dict_find(iter, MESSAGE_KEY_ExportRequest)) {
+        Tuple *since = dict_find(iter, MESSAGE_KEY_SyncSince);
+        app_comm_export_history(since ? since->value->uint32 : 0);
+    }
+#if ENABLE_TRACE
+    if (dict_find(iter, MESSAGE_KEY_TraceDump)) {
+        trace_dump();
+    }
+#endif
+}
+
+static void outbox_sent_handler(DictionaryIterator *iter, void *context) {
+    history_export_chunk_acked();
+}
+
+static void outbox_failed_handler(DictionaryIterator *iter, AppMessageResult reason, void *context) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "outbox failed: %d", (int)reason);
+    history_export_chunk_nacked();
+}
+
+void app_comm_init(void) {
+    uint32_t outbox = MIN(app_message_outbox_size_maximum(), APP_COMM_OUTBOX_SIZE);
+
+    // Whole records only, after room for the dictionary header and every
+    // tuple of an export chunk
+    const Tuplet chunk[] = {
+        TupletInteger(MESSAGE_KEY_ExportSeq, (int32_t)0),
+        TupletInteger(MESSAGE_KEY_ExportTotal, (int32_t)0),
+        TupletInteger(MESSAGE_KEY_ExportFirstSeq, (uint32_t)0),
+        TupletBytes(MESSAGE_KEY_ExportRecords, NULL, 0),
+    };
+    uint32_t overhead = dict_calc_buffered_size_from_tuplets(chunk, ARRAY_LENGTH(chunk));
+    s_transport.send_chunk = send_export_chunk;
+    s_transport.max_payload = ((outbox - overhead) / RECORD_ENCODED_SIZE) * RECORD_ENCODED_SIZE;
+
+    app_message_register_inbox_received(inbox_received_handler);
+    app_message_register_outbox_sent(outbox_sent_handler);
+    app_message_register_outbox_failed(outbox_failed_handler);
+    app_message_open(APP_COMM_INBOX_SIZE, outbox);
+}
+
+void app_comm_deinit(void) {
+    history_export_cancel();
+    app_message_deregister_callbacks();
+}
+
+bool app_comm_export_history(uint32_t since_seq) {
+    return history_export_start(&s_transport, since_seq, export_done);
+}
+
+bool app_comm_sync_history(void) {
+    return s_phone_seq_known && app_comm_export_history(s_phone_seq);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+
+// AppMessage link to the phone. Owns the inbox/outbox, routes outbox
+// results to whichever sender is active (currently the history export) and
+// stores records the phone sends back.
+
+#define APP_COMM_INBOX_SIZE       256
+#define APP_COMM_OUTBOX_SIZE      512
+#define APP_COMM_IMPORT_MAX       16   // Records per ImportRecords message
+
+void app_comm_init(void);
+void app_comm_deinit(void);
+
+// Start sending the phone the records from since_seq on (its watermark);
+// returns false if an export is running
+bool app_comm_export_history(uint32_t since_seq);
+
+// Send the records saved since the phone's last completed sync. Returns
+// false if no sync has completed since launch, or an export is running.
+bool app_comm_sync_history(void);
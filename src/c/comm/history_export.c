@@ -0,0 +1,177 @@
+#include "history_export.h"
+#include "../data/storage.h"
+#include "../ui/render_scheduler.h"
+
+// Records loaded from storage per batch while filling a chunk
+#define EXPORT_LOAD_BATCH  8
+
+static struct {
+    bool active;
+    const ExportTransport *transport;
+    ExportDoneCallback done;
+
+    uint16_t total;             // Records in this export
+    uint32_t next_seq;          // First record of the in-flight chunk
+    uint32_t end_seq;           // Past the last record of this export
+    uint16_t chunk_records;     // Records in the in-flight chunk
+    uint16_t chunk_length;      // Bytes in the in-flight chunk
+    uint16_t seq;
+    uint8_t attempts;           // Consecutive NACKs of the in-flight chunk
+
+    uint8_t *payload;           // Heap buffer of transport->max_payload bytes
+    AppTimer *retry_timer;
+    uint32_t start_ms;
+    ExportStats stats;
+} s_export;
+
+static void finish(bool success) {
+    if (s_export.retry_timer) {
+        app_timer_cancel(s_export.retry_timer);
+        s_export.retry_timer = NULL;
+    }
+    free(s_export.payload);
+    s_export.payload = NULL;
+    s_export.active = false;
+    s_export.stats.elapsed_ms = render_clock_ms() - s_export.start_ms;
+    s_export.stats.next_seq = s_export.next_seq;
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "history export %s: %ld records, %ld chunks, %ld retries, %ld ms",
+            success ? "done" : "failed", (long)s_export.stats.records_sent,
+            (long)s_export.stats.chunks_sent, (long)s_export.stats.retries,
+            (long)s_export.stats.elapsed_ms);
+
+    if (s_export.done) {
+        s_export.done(success, &s_export.stats);
+    }
+}
+
+// History index of a sequence number (records may have been evicted, or
+// saved, since the export started)
+static int seq_to_index(uint32_t seq) {
+    uint32_t oldest = storage_get_history_next_seq() - storage_get_history_count();
+    return (int)(seq - oldest);
+}
+
+// Pack as many encoded records as fit, starting at next_seq
+static void build_chunk(void) {
+    TreatmentRecord batch[EXPORT_LOAD_BATCH];
+
+    // Records evicted since the start are skipped
+    int start = seq_to_index(s_export.next_seq);
+    if (start < 0) {
+        s_export.next_seq = MIN(s_export.next_seq + (uint32_t)-start, s_export.end_seq);
+        start = 0;
+    }
+
+    uint16_t capacity = s_export.transport->max_payload / RECORD_ENCODED_SIZE;
+    uint32_t remaining = s_export.end_seq - s_export.next_seq;
+    uint16_t count = (remaining < capacity) ? remaining : capacity;
+
+    s_export.chunk_records = 0;
+    while (s_export.chunk_records < count) {
+        int want = count - s_export.chunk_records;
+        if (want > EXPORT_LOAD_BATCH) want = EXPORT_LOAD_BATCH;
+
+        int loaded = storage_load_history_range(start + s_export.chunk_records, want, batch);
+        for (int i = 0; i < loaded; i++) {
+            record_encode(&batch[i], &s_export.payload[s_export.chunk_records * RECORD_ENCODED_SIZE]);
+            s_export.chunk_records++;
+        }
+        if (loaded < want) {
+            break;
+        }
+    }
+    s_export.chunk_length = s_export.chunk_records * RECORD_ENCODED_SIZE;
+    s_export.attempts = 0;
+}
+
+static void send_chunk(void) {
+    if (!s_export.transport->send_chunk(s_export.seq, s_export.total, s_export.next_seq,
+                                        s_export.payload, s_export.chunk_length)) {
+        history_export_chunk_nacked();
+    }
+}
+
+static void retry_timer_callback(void *context) {
+    s_export.retry_timer = NULL;
+    send_chunk();
+}
+
+bool history_export_start(const ExportTransport *transport, uint32_t since_seq,
+                          ExportDoneCallback done) {
+    if (s_export.active) {
+        return false;
+    }
+
+    memset(&s_export, 0, sizeof(s_export));
+    s_export.payload = malloc(transport->max_payload);
+    if (!s_export.payload || transport->max_payload < RECORD_ENCODED_SIZE) {
+        free(s_export.payload);
+        s_export.payload = NULL;
+        return false;
+    }
+
+    // Records saved from here on are left for the next sync
+    s_export.end_seq = storage_get_history_next_seq();
+    uint32_t oldest = s_export.end_seq - storage_get_history_count();
+    if (since_seq > s_export.end_seq) {
+        since_seq = 0;
+    }
+    s_export.next_seq = (since_seq > oldest) ? since_seq : oldest;
+    s_export.total = s_export.end_seq - s_export.next_seq;
+    s_export.transport = transport;
+    s_export.done = done;
+    s_export.active = true;
+    s_export.start_ms = render_clock_ms();
+
+    // Nothing new still sends one (empty) chunk so the phone sees total = 0
+    build_chunk();
+    send_chunk();
+    return true;
+}
+
+void history_export_cancel(void) {
+    if (s_export.active) {
+        finish(false);
+    }
+}
+
+bool history_export_is_active(void) {
+    return s_export.active;
+}
+
+void history_export_chunk_acked(void) {
+    if (!s_export.active) {
+        return;
+    }
+
+    s_export.stats.chunks_sent++;
+    s_export.stats.records_sent += s_export.chunk_records;
+    s_export.next_seq += s_export.chunk_records;
+    s_export.seq++;
+
+    if (s_export.next_seq >= s_export.end_seq || s_export.chunk_records == 0) {
+        finish(true);
+        return;
+    }
+
+    // Pipeline the next chunk immediately
+    build_chunk();
+    send_chunk();
+}
+
+void history_export_chunk_nacked(void) {
+    if (!s_export.active) {
+        return;
+    }
+
+    s_export.attempts++;
+    if (s_export.attempts > EXPORT_MAX_RETRIES) {
+        finish(false);
+        return;
+    }
+
+    s_export.stats.retries++;
+    uint32_t delay = (uint32_t)EXPORT_RETRY_BASE_MS << (s_export.attempts - 1);
+    s_export.retry_timer = app_timer_register(delay, retry_timer_callback, NULL);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+
+// Streams history to the phone in chunks of packed encoded records. Only
+// records from the receiver's watermark (the sequence number it needs
+// next) on are sent, so a sync after a gap sends just what is missing.
+// The next chunk goes out as soon as the previous one is ACKed; NACKs are
+// retried with exponential backoff.
+
+#define EXPORT_MAX_RETRIES       5
+#define EXPORT_RETRY_BASE_MS     100     // Doubles on each consecutive NACK
+
+// Link used to deliver chunks. The outcome of every accepted send must be
+// reported with history_export_chunk_acked() or history_export_chunk_nacked().
+typedef struct {
+    // Queue one chunk; first_seq is the sequence number of its first
+    // record. Returns false if the link could not accept it.
+    bool (*send_chunk)(uint16_t seq, uint16_t total, uint32_t first_seq,
+                       const uint8_t *payload, uint16_t length);
+    uint16_t max_payload;       // Record bytes that fit in one message
+} ExportTransport;
+
+typedef struct {
+    uint32_t records_sent;
+    uint32_t chunks_sent;       // ACKed chunks
+    uint32_t retries;
+    uint32_t elapsed_ms;
+    uint32_t next_seq;          // Receiver's watermark once done
+} ExportStats;
+
+typedef void (*ExportDoneCallback)(bool success, const ExportStats *stats);
+
+// Start exporting the records from since_seq on (0 for all). A since_seq
+// past the log's next sequence number means the log was cleared since the
+// receiver's last sync, and everything is sent. Returns false if an export
+// is already running.
+bool history_export_start(const ExportTransport *transport, uint32_t since_seq,
+                          ExportDoneCallback done);
+void history_export_cancel(void);
+bool history_export_is_active(void);
+
+// Delivery outcome of the last chunk handed to the transport
+void history_export_chunk_acked(void);
+void history_export_chunk_nacked(void);
@@ -0,0 +1,104 @@
+#include "history_cache.h"
+#include "storage.h"
+#include "../ui/render_scheduler.h"
+
+void history_cache_init(HistoryCache *cache) {
+    memset(cache, 0, sizeof(*cache));
+    for (int i = 0; i < HISTORY_CACHE_SIZE; i++) {
+        cache->entries[i].index = -1;
+    }
+    cache->last_index = -1;
+}
+
+static HistoryCacheEntry *find(HistoryCache *cache, int index) {
+    for (int i = 0; i < HISTORY_CACHE_SIZE; i++) {
+        if (cache->entries[i].index == index) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Unused entry, else the least recently used one
+static HistoryCacheEntry *victim(HistoryCache *cache) {
+    HistoryCacheEntry *oldest = &cache->entries[0];
+    for (int i = 0; i < HISTORY_CACHE_SIZE; i++) {
+        HistoryCacheEntry *entry = &cache->entries[i];
+        if (entry->index < 0) {
+            return entry;
+        }
+        if ((uint16_t)(cache->clock - entry->last_used) > (uint16_t)(cache->clock - oldest->last_used)) {
+            oldest = entry;
+        }
+    }
+    return oldest;
+}
+
+static void touch(HistoryCache *cache, HistoryCacheEntry *entry) {
+    entry->last_used = ++cache->clock;
+}
+
+static void insert(HistoryCache *cache, int index, const TreatmentRecord *record) {
+    if (find(cache, index)) {
+        return;
+    }
+    HistoryCacheEntry *entry = victim(cache);
+    entry->index = (int16_t)index;
+    entry->record = *record;
+    calculate_post_metrics(&entry->record, &entry->metrics);
+    touch(cache, entry);
+}
+
+// Load a run of records that includes index, extending in the direction the
+// list is being scrolled, with one storage call. The requested record is
+// inserted last so it is the most recently used.
+static void load_run(HistoryCache *cache, int index) {
+    TreatmentRecord records[HISTORY_CACHE_PREFETCH];
+    int start = (cache->direction < 0) ? index - (HISTORY_CACHE_PREFETCH - 1) : index;
+    if (start < 0) {
+        start = 0;
+    }
+
+    int loaded = storage_load_history_range(start, HISTORY_CACHE_PREFETCH, records);
+    for (int i = 0; i < loaded; i++) {
+        if (start + i != index) {
+            insert(cache, start + i, &records[i]);
+        }
+    }
+    if (index - start < loaded) {
+        insert(cache, index, &records[index - start]);
+    }
+}
+
+const HistoryCacheEntry *history_cache_get(HistoryCache *cache, int index) {
+    if (cache->last_index >= 0 && index != cache->last_index) {
+        cache->direction = (index > cache->last_index) ? 1 : -1;
+    }
+    cache->last_index = (int16_t)index;
+
+    HistoryCacheEntry *entry = find(cache, index);
+    if (entry) {
+        cache->stats.hits++;
+        touch(cache, entry);
+        return entry;
+    }
+
+    cache->stats.misses++;
+    uint32_t start = render_clock_ms();
+    load_run(cache, index);
+    cache->stats.load_ms += render_clock_ms() - start;
+
+    return find(cache, index);
+}
+
+void history_cache_log_stats(const HistoryCache *cache, const char *name) {
+    uint32_t lookups = cache->stats.hits + cache->stats.misses;
+    if (lookups == 0) {
+        return;
+    }
+    // Hit rate as x10 percent
+    uint32_t rate_x10 = (cache->stats.hits * 1000) / lookups;
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "%s cache: %ld hits, %ld misses (%ld.%ld%% hit), %ld ms loading",
+            name, (long)cache->stats.hits, (long)cache->stats.misses,
+            (long)(rate_x10 / 10), (long)(rate_x10 % 10), (long)cache->stats.load_ms);
+}
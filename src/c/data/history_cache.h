@@ -0,0 +1,45 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "treatment_data.h"
+
+// Small LRU of decoded history records with their metrics, so redrawing a
+// row already seen costs neither a flash read nor calculate_post_metrics().
+// Fixed size, so memory stays bounded however long the history is.
+
+#define HISTORY_CACHE_SIZE      8
+#define HISTORY_CACHE_PREFETCH  4   // Neighbouring records loaded on a miss
+
+typedef struct {
+    int16_t index;              // History index, -1 if unused
+    uint16_t last_used;
+    TreatmentRecord record;
+    CalculatedMetrics metrics;
+} HistoryCacheEntry;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t load_ms;           // Time spent loading on misses
+} HistoryCacheStats;
+
+typedef struct {
+    HistoryCacheEntry entries[HISTORY_CACHE_SIZE];
+    uint16_t clock;
+    int8_t direction;           // Last scroll direction, for prefetch
+    int16_t last_index;
+    HistoryCacheStats stats;
+} HistoryCache;
+
+void history_cache_init(HistoryCache *cache);
+
+// Entry for history index (0 = oldest), loading it on a miss. Returns NULL
+// if the record cannot be read. Valid until the next history_cache_get().
+const HistoryCacheEntry *history_cache_get(HistoryCache *cache, int index);
+
+// Log hit rate and load time
+void history_cache_log_stats(const HistoryCache *cache, const char *name);
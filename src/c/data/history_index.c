@@ -0,0 +1,121 @@
+#include "history_index.h"
+
+// 1970-01-01 was a Thursday; weeks start on the following Monday
+#define FIRST_MONDAY  (4 * 24 * 60 * 60)
+
+uint16_t history_index_week(time_t timestamp) {
+    if (timestamp < FIRST_MONDAY) {
+        return 0;
+    }
+    uint32_t week = (uint32_t)(timestamp - FIRST_MONDAY) / HISTORY_INDEX_WEEK_SECONDS;
+    return (week > UINT16_MAX) ? UINT16_MAX : (uint16_t)week;
+}
+
+time_t history_index_week_start(uint16_t week) {
+    return FIRST_MONDAY + (time_t)week * HISTORY_INDEX_WEEK_SECONDS;
+}
+
+void history_index_init(HistoryIndex *index, uint32_t next_seq) {
+    memset(index, 0, sizeof(*index));
+    index->base_seq = next_seq;
+    index->sorted = 1;
+}
+
+// Drop the first n buckets and move base_seq on by shift
+static void rebase(HistoryIndex *index, int n, uint32_t shift) {
+    for (int i = n; i < index->week_count; i++) {
+        index->weeks[i - n].week = index->weeks[i].week;
+        index->weeks[i - n].end = index->weeks[i].end - shift;
+    }
+    index->week_count -= n;
+    index->base_seq += shift;
+}
+
+void history_index_add(HistoryIndex *index, const TreatmentRecord *record, uint32_t seq) {
+    uint32_t timestamp = (record->timestamp > 0) ? (uint32_t)record->timestamp : 0;
+    if (timestamp < index->last_timestamp) {
+        index->sorted = 0;
+        index->unsorted_seq = seq;
+        return;
+    }
+    index->last_timestamp = timestamp;
+    if (!index->sorted) {
+        return;
+    }
+
+    uint16_t week = history_index_week(timestamp);
+    int last = index->week_count - 1;
+    if (last >= 0 && index->weeks[last].week == week) {
+        index->weeks[last].end = seq + 1 - index->base_seq;
+        return;
+    }
+
+    if (index->week_count == HISTORY_INDEX_MAX_WEEKS) {
+        rebase(index, 1, index->weeks[0].end);
+    }
+    index->weeks[index->week_count].week = week;
+    index->weeks[index->week_count].end = seq + 1 - index->base_seq;
+    index->week_count++;
+}
+
+bool history_index_evict(HistoryIndex *index, uint32_t oldest_seq) {
+    // Records below base_seq belong to weeks already dropped
+    if (oldest_seq > index->base_seq) {
+        uint32_t shift = oldest_seq - index->base_seq;
+        int n = 0;
+        while (n < index->week_count && index->weeks[n].end <= shift) {
+            n++;
+        }
+        rebase(index, n, shift);
+    }
+    return !index->sorted && oldest_seq > index->unsorted_seq;
+}
+
+// First bucket whose week is >= week
+static int lower_bound(const HistoryIndex *index, uint32_t week) {
+    int lo = 0;
+    int hi = index->week_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (index->weeks[mid].week < week) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Offset of the first record of bucket i
+static uint32_t bucket_start(const HistoryIndex *index, int i) {
+    return (i == 0) ? 0 : index->weeks[i - 1].end;
+}
+
+bool history_index_span(const HistoryIndex *index, time_t from, time_t to,
+                        uint32_t *first_seq, uint32_t *end_seq) {
+    if (!index->sorted) {
+        return false;
+    }
+    if (to <= from) {
+        *first_seq = *end_seq = index->base_seq;
+        return true;
+    }
+
+    int first = lower_bound(index, history_index_week(from));
+    int end = lower_bound(index, (uint32_t)history_index_week(to - 1) + 1);
+
+    *first_seq = (first == 0) ? 0 : index->base_seq + bucket_start(index, first);
+    *end_seq = index->base_seq + bucket_start(index, end);
+    return true;
+}
+
+uint16_t history_index_week_count(const HistoryIndex *index, uint16_t week) {
+    if (!index->sorted) {
+        return 0;
+    }
+    int i = lower_bound(index, week);
+    if (i == index->week_count || index->weeks[i].week != week) {
+        return 0;
+    }
+    return index->weeks[i].end - bucket_start(index, i);
+}
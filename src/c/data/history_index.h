@@ -0,0 +1,65 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "treatment_data.h"
+
+// Calendar-week buckets over the history log, so date-range queries decode
+// only the pages that can hold matching records.
+//
+// Each bucket is a week (Monday 00:00 UTC on) and the offset, from
+// base_seq, just past the sequence number of its last record. While
+// timestamps never go backwards the buckets are sorted by week and the
+// records of any date range are consecutive, so a binary search over the
+// buckets gives the sequence numbers to read. A timestamp that goes
+// backwards (clock change) disables the index until that record has been
+// evicted. Buckets and counts are updated in O(1) per append and O(weeks)
+// per page eviction. All fields are naturally aligned, so the persisted
+// layout has no padding.
+
+#define HISTORY_INDEX_MAX_WEEKS  56     // ~13 months; older weeks are dropped
+#define HISTORY_INDEX_WEEK_SECONDS  (7 * 24 * 60 * 60)
+
+typedef struct {
+    uint16_t week;              // history_index_week() of its records
+    uint16_t end;               // Offset from base_seq past its last record
+} WeekBucket;
+
+typedef struct {
+    uint32_t base_seq;          // Sequence number bucket offsets count from
+    uint32_t last_timestamp;    // Newest record appended
+    uint32_t unsorted_seq;      // Newest out-of-order record (if !sorted)
+    uint16_t week_count;        // Buckets used, oldest first
+    uint8_t sorted;             // Timestamps non-decreasing in log order
+    uint8_t reserved;
+    WeekBucket weeks[HISTORY_INDEX_MAX_WEEKS];
+} HistoryIndex;
+
+// Empty index; the next record appended will be next_seq
+void history_index_init(HistoryIndex *index, uint32_t next_seq);
+
+// Fold in the record just appended as sequence number seq
+void history_index_add(HistoryIndex *index, const TreatmentRecord *record, uint32_t seq);
+
+// Records before oldest_seq were evicted; drops the buckets they emptied.
+// Returns true once the last out-of-order record is gone, when the index
+// should be rebuilt from the remaining records to enable it again.
+bool history_index_evict(HistoryIndex *index, uint32_t oldest_seq);
+
+// Sequence numbers [*first_seq, *end_seq) holding every record with
+// from <= timestamp < to (and possibly a few either side, in the same
+// weeks). *first_seq is 0 if the range starts before the oldest bucket.
+// Returns false if the index cannot narrow the range.
+bool history_index_span(const HistoryIndex *index, time_t from, time_t to,
+                        uint32_t *first_seq, uint32_t *end_seq);
+
+// Records in a week (0 if none or the index is disabled), for
+// calendar-style views
+uint16_t history_index_week_count(const HistoryIndex *index, uint16_t week);
+
+// Week number of a timestamp (0 = week of Monday 1970-01-05) and back
+uint16_t history_index_week(time_t timestamp);
+time_t history_index_week_start(uint16_t week);
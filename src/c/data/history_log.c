@@ -0,0 +1,243 @@
+#include "history_log.h"
+#include "record_codec.h"
+
+// ---------------------------------------------------------------------------
+// Varints - 7 bits per byte, low group first, high bit set on all but the last
+// ---------------------------------------------------------------------------
+
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static int put_varint(uint8_t *out, uint32_t value) {
+    int n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// Returns bytes consumed, or 0 if the varint runs past end
+static int get_varint(const uint8_t *in, const uint8_t *end, uint32_t *value) {
+    uint32_t result = 0;
+    int shift = 0;
+    int n = 0;
+    while (in + n < end && shift < 35) {
+        uint8_t byte = in[n++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return n;
+        }
+        shift += 7;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Record deltas
+// ---------------------------------------------------------------------------
+
+static int encode_delta(const TreatmentRecord *prev, const TreatmentRecord *record, uint8_t *out) {
+    int n = 0;
+    out[n++] = record_pack_flags(record);
+    n += put_varint(&out[n], zigzag(record->pre_weight - prev->pre_weight));
+    n += put_varint(&out[n], zigzag(record->dry_weight - prev->dry_weight));
+    n += put_varint(&out[n], zigzag(record->post_weight - prev->post_weight));
+    n += put_varint(&out[n], zigzag((int32_t)((uint32_t)record->timestamp - (uint32_t)prev->timestamp)));
+    return n;
+}
+
+// Returns bytes consumed, or 0 if the record is truncated
+static int decode_delta(const TreatmentRecord *prev, const uint8_t *in, const uint8_t *end,
+                        TreatmentRecord *record) {
+    uint32_t fields[4];
+    int n = 1;
+
+    if (in >= end) {
+        return 0;
+    }
+    for (int i = 0; i < 4; i++) {
+        int used = get_varint(&in[n], end, &fields[i]);
+        if (used == 0) {
+            return 0;
+        }
+        n += used;
+    }
+
+    record_unpack_flags(in[0], record);
+    record->pre_weight = prev->pre_weight + unzigzag(fields[0]);
+    record->dry_weight = prev->dry_weight + unzigzag(fields[1]);
+    record->post_weight = prev->post_weight + unzigzag(fields[2]);
+    record->timestamp = (time_t)((uint32_t)prev->timestamp + (uint32_t)unzigzag(fields[3]));
+    return n;
+}
+
+// ---------------------------------------------------------------------------
+// Formats - decoders and upgrades by page format, oldest first
+// ---------------------------------------------------------------------------
+
+static const LogFormat s_formats[] = {
+    { decode_delta, NULL },     // 2: flags + four delta varints
+};
+
+static const LogSchema s_builtin_schema = {
+    .oldest = HISTORY_LOG_OLDEST_FORMAT,
+    .current = HISTORY_LOG_FORMAT,
+    .formats = s_formats
+};
+
+static const LogSchema *s_schema = &s_builtin_schema;
+
+const LogSchema *history_log_get_schema(void) {
+    return s_schema;
+}
+
+#if ENABLE_BENCHMARKS
+void history_log_set_schema(const LogSchema *schema) {
+    s_schema = schema ? schema : &s_builtin_schema;
+}
+#endif
+
+static const LogFormat *format_of(uint8_t format) {
+    return &s_schema->formats[format - s_schema->oldest];
+}
+
+// ---------------------------------------------------------------------------
+// Pages
+// ---------------------------------------------------------------------------
+
+#define CRC_OFFSET  6
+
+static uint16_t crc16_update(uint16_t crc, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// CRC of everything except the CRC field itself
+static uint16_t page_crc(const uint8_t *data, uint16_t length) {
+    uint16_t crc = crc16_update(0xFFFF, data, CRC_OFFSET);
+    return crc16_update(crc, &data[HISTORY_LOG_HEADER_SIZE], length - HISTORY_LOG_HEADER_SIZE);
+}
+
+// Refresh the count and CRC after the records changed
+static void seal(LogPage *page) {
+    page->data[1] = page->count;
+    uint16_t crc = page_crc(page->data, page->length);
+    page->data[CRC_OFFSET] = (uint8_t)(crc & 0xFF);
+    page->data[CRC_OFFSET + 1] = (uint8_t)(crc >> 8);
+}
+
+void history_log_page_init(LogPage *page, uint32_t first_seq) {
+    page->data[0] = s_schema->current;
+    page->data[2] = (uint8_t)(first_seq & 0xFF);
+    page->data[3] = (uint8_t)((first_seq >> 8) & 0xFF);
+    page->data[4] = (uint8_t)((first_seq >> 16) & 0xFF);
+    page->data[5] = (uint8_t)((first_seq >> 24) & 0xFF);
+    page->length = HISTORY_LOG_HEADER_SIZE;
+    page->count = 0;
+    page->format = s_schema->current;
+    page->first_seq = first_seq;
+    memset(&page->last, 0, sizeof(page->last));
+    seal(page);
+}
+
+bool history_log_header_decode(const uint8_t *data, size_t length,
+                               uint32_t *first_seq, uint8_t *count) {
+    if (length < HISTORY_LOG_HEADER_SIZE ||
+        data[0] < s_schema->oldest || data[0] > s_schema->current) {
+        return false;
+    }
+    *count = data[1];
+    *first_seq = (uint32_t)data[2] | ((uint32_t)data[3] << 8) |
+                 ((uint32_t)data[4] << 16) | ((uint32_t)data[5] << 24);
+    return true;
+}
+
+bool history_log_header_is_current(const uint8_t *data) {
+    return data[0] == s_schema->current;
+}
+
+bool history_log_page_parse(LogPage *page, uint16_t length) {
+    if (length > HISTORY_LOG_PAGE_SIZE ||
+        !history_log_header_decode(page->data, length, &page->first_seq, &page->count)) {
+        return false;
+    }
+    uint16_t stored_crc = (uint16_t)(page->data[CRC_OFFSET] | (page->data[CRC_OFFSET + 1] << 8));
+    if (stored_crc != page_crc(page->data, length)) {
+        return false;
+    }
+
+    page->length = length;
+    page->format = page->data[0];
+
+    // Walk the records to recover the delta base and check they all fit
+    LogCursor cursor;
+    TreatmentRecord record;
+    history_log_cursor_init(&cursor, page);
+    while (history_log_cursor_next(&cursor, &record)) {
+    }
+    if (cursor.index != page->count || cursor.offset != length) {
+        return false;
+    }
+    page->last = cursor.prev;
+    return true;
+}
+
+bool history_log_page_append(LogPage *page, const TreatmentRecord *record) {
+    uint8_t encoded[HISTORY_LOG_MAX_RECORD];
+    int size = encode_delta(&page->last, record, encoded);
+
+    if (page->format != s_schema->current || page->count == UINT8_MAX ||
+        page->length + size > HISTORY_LOG_PAGE_SIZE) {
+        return false;
+    }
+
+    memcpy(&page->data[page->length], encoded, size);
+    page->length += size;
+    page->count++;
+    page->last = *record;
+    seal(page);
+    return true;
+}
+
+void history_log_cursor_init(LogCursor *cursor, const LogPage *page) {
+    cursor->page = page;
+    cursor->offset = HISTORY_LOG_HEADER_SIZE;
+    cursor->index = 0;
+    memset(&cursor->prev, 0, sizeof(cursor->prev));
+}
+
+bool history_log_cursor_next(LogCursor *cursor, TreatmentRecord *record) {
+    const LogPage *page = cursor->page;
+    if (cursor->index >= page->count) {
+        return false;
+    }
+
+    int used = format_of(page->format)->decode(&cursor->prev, &page->data[cursor->offset],
+                                               &page->data[page->length], record);
+    if (used == 0) {
+        return false;
+    }
+    cursor->offset += used;
+    cursor->index++;
+    cursor->prev = *record;
+
+    // Deltas are against the stored record; only the copy returned is
+    // upgraded, through every format after the page's
+    for (uint8_t format = page->format; format < s_schema->current; format++) {
+        format_of(format)->upgrade(record);
+    }
+    return true;
+}
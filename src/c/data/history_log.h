@@ -0,0 +1,117 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "treatment_data.h"
+#include "../debug/debug_config.h"
+
+// Delta-compressed history page. Each page is one persist value holding a
+// run of consecutive treatments; every record is stored as varint deltas
+// against the one before it, and the first record of a page against an
+// all-zero record, so pages decode independently and can be evicted whole.
+// Writing a page is the commit point of an append: the header carries the
+// sequence number of its first record (record i has first_seq + i) and a
+// CRC over the whole page, so a damaged page is detected and never decoded.
+//
+//   offset  size  field
+//   0       1     page format (HISTORY_LOG_FORMAT)
+//   1       1     record count
+//   2       4     sequence number of the first record (u32, little-endian)
+//   6       2     CRC-16/CCITT of bytes 0-5 and the records (little-endian)
+//   8       ...   records, each:
+//                   flags byte (as in record_codec.h)
+//                   zigzag varint  pre_weight  - previous pre_weight
+//                   zigzag varint  dry_weight  - previous dry_weight
+//                   zigzag varint  post_weight - previous post_weight
+//                   zigzag varint  timestamp   - previous timestamp
+//
+// A typical treatment (same dry weight, weights within +/-6.3 kg, sessions
+// under 24 days apart) takes 7-8 bytes instead of 12.
+//
+// The page format is the version of its records. Every format keeps the
+// header above; a new one (e.g. for a field added to TreatmentRecord)
+// registers how its records are decoded and how a record of the format
+// before it is upgraded. Pages of older formats are read as stored and
+// their records upgraded one at a time as the cursor returns them, so
+// nothing is converted at startup. Appends always start a page in the
+// current format, and the storage layer rewrites older pages in the
+// background.
+
+#define HISTORY_LOG_FORMAT       2      // Format of the pages written
+#define HISTORY_LOG_OLDEST_FORMAT 2     // Oldest format still read
+#define HISTORY_LOG_PAGE_SIZE    PERSIST_DATA_MAX_LENGTH
+#define HISTORY_LOG_HEADER_SIZE  8
+#define HISTORY_LOG_MAX_RECORD   (1 + 3 * 5 + 5)  // Flags + worst-case varints
+
+// How the records of one page format are read
+typedef struct {
+    // Decode a record against the previous one of the page (as stored);
+    // returns bytes consumed, or 0 if the record is truncated
+    int (*decode)(const TreatmentRecord *prev, const uint8_t *in, const uint8_t *end,
+                  TreatmentRecord *record);
+    // Turn a record of this format into one of the next (NULL for the
+    // newest format)
+    void (*upgrade)(TreatmentRecord *record);
+} LogFormat;
+
+// Registry of the formats oldest..current, one entry each
+typedef struct {
+    uint8_t oldest;
+    uint8_t current;
+    const LogFormat *formats;
+} LogSchema;
+
+typedef struct {
+    uint8_t data[HISTORY_LOG_PAGE_SIZE];
+    uint16_t length;            // Bytes used, including the header
+    uint8_t count;              // Records in the page
+    uint8_t format;             // Format it was written in
+    uint32_t first_seq;         // Sequence number of the first record
+    TreatmentRecord last;       // Delta base for the next append
+} LogPage;
+
+// Sequential reader over one page
+typedef struct {
+    const LogPage *page;
+    uint16_t offset;
+    uint8_t index;
+    TreatmentRecord prev;
+} LogCursor;
+
+// Start an empty page whose first record will be first_seq
+void history_log_page_init(LogPage *page, uint32_t first_seq);
+
+// Validate length bytes already read into page->data (CRC included) and
+// rebuild count/first_seq/last. Returns false if the page is damaged.
+bool history_log_page_parse(LogPage *page, uint16_t length);
+
+// Decode just the header (e.g. from a HISTORY_LOG_HEADER_SIZE read);
+// the CRC is not checked. Returns false if it is not a log page in a
+// format that can be read.
+bool history_log_header_decode(const uint8_t *data, size_t length,
+                               uint32_t *first_seq, uint8_t *count);
+
+// Whether a page with this header is in the current format, or is read
+// through upgrades until it is rewritten
+bool history_log_header_is_current(const uint8_t *data);
+
+// Append a record; returns false (page unchanged) if it does not fit, or
+// if the page is in an older format
+bool history_log_page_append(LogPage *page, const TreatmentRecord *record);
+
+void history_log_cursor_init(LogCursor *cursor, const LogPage *page);
+
+// Decode the next record, upgraded to the current format; returns false
+// at the end of the page
+bool history_log_cursor_next(LogCursor *cursor, TreatmentRecord *record);
+
+const LogSchema *history_log_get_schema(void);
+
+#if ENABLE_BENCHMARKS
+// Replace the format registry (NULL restores the built-in one), so a
+// test can write pages in one format and read them back in a later one
+void history_log_set_schema(const LogSchema *schema);
+#endif
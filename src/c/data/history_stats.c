@@ -0,0 +1,127 @@
+#include "history_stats.h"
+
+static bool in_band(const CalculatedMetrics *metrics) {
+    return metrics->actual_removal >= metrics->optimistic &&
+           metrics->actual_removal <= metrics->pessimistic;
+}
+
+void history_stats_init(HistoryStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+    history_stats_reset_extremes(stats);
+}
+
+void history_stats_add(HistoryStats *stats, const TreatmentRecord *record) {
+    if (!record->is_complete) {
+        return;
+    }
+
+    CalculatedMetrics metrics;
+    calculate_post_metrics(record, &metrics);
+
+    stats->count++;
+    if (in_band(&metrics)) {
+        stats->in_band++;
+    }
+    stats->sum_removal += metrics.actual_removal;
+    stats->sum_ufr += metrics.ufr;
+    stats->sum_percentage += metrics.percentage;
+    stats->sum_removal_sq += (int64_t)metrics.actual_removal * metrics.actual_removal;
+    stats->sum_percentage_sq += (int64_t)metrics.percentage * metrics.percentage;
+    history_stats_include_extremes(stats, record);
+}
+
+bool history_stats_remove(HistoryStats *stats, const TreatmentRecord *record) {
+    if (!record->is_complete || stats->count == 0) {
+        return false;
+    }
+
+    CalculatedMetrics metrics;
+    calculate_post_metrics(record, &metrics);
+
+    stats->count--;
+    if (in_band(&metrics) && stats->in_band > 0) {
+        stats->in_band--;
+    }
+    stats->sum_removal -= metrics.actual_removal;
+    stats->sum_ufr -= metrics.ufr;
+    stats->sum_percentage -= metrics.percentage;
+    stats->sum_removal_sq -= (int64_t)metrics.actual_removal * metrics.actual_removal;
+    stats->sum_percentage_sq -= (int64_t)metrics.percentage * metrics.percentage;
+
+    return metrics.actual_removal == stats->min_removal ||
+           metrics.actual_removal == stats->max_removal;
+}
+
+void history_stats_reset_extremes(HistoryStats *stats) {
+    stats->min_removal = INT32_MAX;
+    stats->max_removal = INT32_MIN;
+}
+
+void history_stats_include_extremes(HistoryStats *stats, const TreatmentRecord *record) {
+    if (!record->is_complete) {
+        return;
+    }
+    int32_t removal = record->pre_weight - record->post_weight;
+    if (removal < stats->min_removal) stats->min_removal = removal;
+    if (removal > stats->max_removal) stats->max_removal = removal;
+}
+
+// ---------------------------------------------------------------------------
+// Derived values
+// ---------------------------------------------------------------------------
+
+static uint32_t isqrt64(uint64_t value) {
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// Population standard deviation from a sum and sum of squares, in the
+// units of the summed values
+static int32_t stddev(int32_t sum, int64_t sum_sq, uint16_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    // n * sum_sq - sum^2 = n^2 * variance
+    int64_t scaled = (int64_t)count * sum_sq - (int64_t)sum * sum;
+    if (scaled <= 0) {
+        return 0;
+    }
+    return (int32_t)(isqrt64((uint64_t)scaled) / count);
+}
+
+int32_t history_stats_mean_removal(const HistoryStats *stats) {
+    return stats->count ? stats->sum_removal / stats->count : 0;
+}
+
+int32_t history_stats_stddev_removal(const HistoryStats *stats) {
+    return stddev(stats->sum_removal, stats->sum_removal_sq, stats->count);
+}
+
+int32_t history_stats_mean_ufr(const HistoryStats *stats) {
+    return stats->count ? stats->sum_ufr / stats->count : 0;
+}
+
+int32_t history_stats_mean_percentage(const HistoryStats *stats) {
+    return stats->count ? stats->sum_percentage / stats->count : 0;
+}
+
+int32_t history_stats_stddev_percentage(const HistoryStats *stats) {
+    return stddev(stats->sum_percentage, stats->sum_percentage_sq, stats->count);
+}
+
+int32_t history_stats_in_band_rate(const HistoryStats *stats) {
+    return stats->count ? ((int32_t)stats->in_band * 1000) / stats->count : 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "treatment_data.h"
+
+// Running aggregate over the completed treatments in history, updated in
+// O(1) per append and eviction so summaries never re-scan the log.
+// Units follow CalculatedMetrics. All fields are naturally aligned, so the
+// persisted layout has no padding.
+typedef struct {
+    uint16_t count;             // Completed treatments included
+    uint16_t in_band;           // Removal within [optimistic, pessimistic]
+    int32_t min_removal;        // x10
+    int32_t max_removal;        // x10
+    int32_t sum_removal;        // x10
+    int32_t sum_ufr;            // x100
+    int32_t sum_percentage;     // x10
+    int64_t sum_removal_sq;     // x100
+    int64_t sum_percentage_sq;  // x100
+} HistoryStats;
+
+void history_stats_init(HistoryStats *stats);
+void history_stats_add(HistoryStats *stats, const TreatmentRecord *record);
+
+// Subtract an evicted record. Returns true if it held the minimum or
+// maximum, which then have to be recomputed from the remaining records.
+bool history_stats_remove(HistoryStats *stats, const TreatmentRecord *record);
+
+// Restart min/max tracking before re-feeding the remaining records
+void history_stats_reset_extremes(HistoryStats *stats);
+void history_stats_include_extremes(HistoryStats *stats, const TreatmentRecord *record);
+
+// Derived values (0 when empty)
+int32_t history_stats_mean_removal(const HistoryStats *stats);       // x10
+int32_t history_stats_stddev_removal(const HistoryStats *stats);     // x10
+int32_t history_stats_mean_ufr(const HistoryStats *stats);           // x100
+int32_t history_stats_mean_percentage(const HistoryStats *stats);    // x10
+int32_t history_stats_stddev_percentage(const HistoryStats *stats);  // x10
+int32_t history_stats_in_band_rate(const HistoryStats *stats);       // x10 percent
@@ -0,0 +1,64 @@
+#include "metrics_batch.h"
+
+void metrics_batch_clear(MetricsBatch *batch) {
+    batch->count = 0;
+}
+
+bool metrics_batch_add(MetricsBatch *batch, const TreatmentRecord *record) {
+    if (batch->count >= METRICS_BATCH_MAX) {
+        return false;
+    }
+    int i = batch->count++;
+    batch->k_goal[i] = record->pre_weight - record->dry_weight;
+    batch->delta[i] = get_delta_value(record->delta_selection);
+    batch->minutes[i] = record->treatment_time;
+    return true;
+}
+
+void metrics_batch_plan(MetricsBatch *batch, const TreatmentRecord *record) {
+    int32_t k = record->pre_weight - record->dry_weight;
+
+    for (int sel = 0; sel < METRICS_PLAN_DELTAS; sel++) {
+        int32_t delta = get_delta_value(sel);
+        int16_t minutes = METRICS_PLAN_MIN_MINUTES;
+        for (int i = 0; i < METRICS_PLAN_DURATIONS; i++) {
+            int row = metrics_plan_row(sel, i);
+            batch->k_goal[row] = k;
+            batch->delta[row] = delta;
+            batch->minutes[row] = minutes;
+            minutes += METRICS_PLAN_STEP_MINUTES;
+        }
+    }
+    batch->count = METRICS_BATCH_MAX;
+    metrics_batch_run(batch);
+}
+
+void metrics_batch_run(MetricsBatch *batch) {
+    // Same formulas as calculate_pre_metrics(): UFR_x100 = k_x10 * 600 / minutes
+    for (int i = 0; i < batch->count; i++) {
+        int32_t k = batch->k_goal[i];
+        int32_t optimistic = k - batch->delta[i];
+        int32_t pessimistic = k + batch->delta[i];
+        int32_t minutes = batch->minutes[i];
+
+        batch->optimistic[i] = optimistic;
+        batch->pessimistic[i] = pessimistic;
+        if (minutes > 0) {
+            batch->ufr[i] = (k * 600) / minutes;
+            batch->ufr_optimistic[i] = (optimistic * 600) / minutes;
+            batch->ufr_pessimistic[i] = (pessimistic * 600) / minutes;
+        } else {
+            batch->ufr[i] = 0;
+            batch->ufr_optimistic[i] = 0;
+            batch->ufr_pessimistic[i] = 0;
+        }
+    }
+}
+
+int metrics_plan_index(int16_t minutes) {
+    int offset = minutes - METRICS_PLAN_MIN_MINUTES;
+    if (offset < 0 || minutes > METRICS_PLAN_MAX_MINUTES || offset % METRICS_PLAN_STEP_MINUTES != 0) {
+        return -1;
+    }
+    return offset / METRICS_PLAN_STEP_MINUTES;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "treatment_data.h"
+
+// Batch form of calculate_pre_metrics(). Scenarios are held as a
+// structure of arrays (one array per input and per result) and the kernel
+// computes every result column in a single pass of integer math, so a whole
+// table costs one loop instead of one call and struct fill per scenario.
+// Results are bit-exact with calculate_pre_metrics().
+//
+// The what-if planner fills it with every allowed treatment time for both
+// delta selections; history analytics can add stored records instead.
+
+// Treatment times the Time field allows (see field_editor.c)
+#define METRICS_PLAN_MIN_MINUTES    60
+#define METRICS_PLAN_MAX_MINUTES    480
+#define METRICS_PLAN_STEP_MINUTES   15
+#define METRICS_PLAN_DURATIONS \
+    ((METRICS_PLAN_MAX_MINUTES - METRICS_PLAN_MIN_MINUTES) / METRICS_PLAN_STEP_MINUTES + 1)
+#define METRICS_PLAN_DELTAS         2
+
+// Enough for a full plan (58 scenarios)
+#define METRICS_BATCH_MAX           (METRICS_PLAN_DURATIONS * METRICS_PLAN_DELTAS)
+
+typedef struct {
+    uint8_t count;
+
+    // Inputs
+    int32_t k_goal[METRICS_BATCH_MAX];          // x10
+    int32_t delta[METRICS_BATCH_MAX];           // x10 (get_delta_value())
+    int16_t minutes[METRICS_BATCH_MAX];
+
+    // Results
+    int32_t optimistic[METRICS_BATCH_MAX];      // x10
+    int32_t pessimistic[METRICS_BATCH_MAX];     // x10
+    int32_t ufr[METRICS_BATCH_MAX];             // x100, to remove k
+    int32_t ufr_optimistic[METRICS_BATCH_MAX];  // x100, to remove the optimistic goal
+    int32_t ufr_pessimistic[METRICS_BATCH_MAX]; // x100, to remove the pessimistic goal
+} MetricsBatch;
+
+void metrics_batch_clear(MetricsBatch *batch);
+
+// Append one scenario taken from a record; returns false if the batch is full
+bool metrics_batch_add(MetricsBatch *batch, const TreatmentRecord *record);
+
+// Replace the contents with the record's goal at every allowed treatment
+// time for both delta selections; see metrics_plan_row() for the layout.
+// Runs the kernel.
+void metrics_batch_plan(MetricsBatch *batch, const TreatmentRecord *record);
+
+// Fill the result columns of every scenario
+void metrics_batch_run(MetricsBatch *batch);
+
+// Row of a planned batch holding delta_selection at duration index i
+// (minutes = METRICS_PLAN_MIN_MINUTES + i * METRICS_PLAN_STEP_MINUTES)
+static inline int metrics_plan_row(int delta_selection, int i) {
+    return delta_selection * METRICS_PLAN_DURATIONS + i;
+}
+
+// Duration index of a treatment time, or -1 if it is not a planned one
+int metrics_plan_index(int16_t minutes);
@@ -0,0 +1,76 @@
+#include "record_codec.h"
+
+#define FLAG_TIME_MASK  0x3F
+#define FLAG_DELTA      0x40
+#define FLAG_COMPLETE   0x80
+
+static void put_u16(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)((value >> 8) & 0xFF);
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)((value >> 8) & 0xFF);
+    out[2] = (uint8_t)((value >> 16) & 0xFF);
+    out[3] = (uint8_t)((value >> 24) & 0xFF);
+}
+
+static uint16_t get_u16(const uint8_t *in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) |
+           ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+uint8_t record_pack_flags(const TreatmentRecord *record) {
+    uint8_t flags = (uint8_t)((record->treatment_time / RECORD_TIME_STEP_MINUTES) & FLAG_TIME_MASK);
+    if (record->delta_selection) flags |= FLAG_DELTA;
+    if (record->is_complete) flags |= FLAG_COMPLETE;
+    return flags;
+}
+
+void record_unpack_flags(uint8_t flags, TreatmentRecord *record) {
+    record->treatment_time = (int16_t)((flags & FLAG_TIME_MASK) * RECORD_TIME_STEP_MINUTES);
+    record->delta_selection = (flags & FLAG_DELTA) ? 1 : 0;
+    record->is_complete = (flags & FLAG_COMPLETE) != 0;
+}
+
+int record_encode(const TreatmentRecord *record, uint8_t *out) {
+    out[0] = RECORD_CODEC_VERSION;
+    put_u16(&out[1], (uint32_t)record->pre_weight);
+    put_u16(&out[3], (uint32_t)record->dry_weight);
+    put_u16(&out[5], (uint32_t)record->post_weight);
+    out[7] = record_pack_flags(record);
+    put_u32(&out[8], (uint32_t)record->timestamp);
+    return RECORD_ENCODED_SIZE;
+}
+
+bool record_decode(const uint8_t *in, size_t length, TreatmentRecord *record) {
+    // Raw struct written by releases before the codec existed
+    if (length == sizeof(LegacyRecord)) {
+        LegacyRecord legacy;
+        memcpy(&legacy, in, sizeof(legacy));
+        record->pre_weight = legacy.pre_weight;
+        record->dry_weight = legacy.dry_weight;
+        record->post_weight = legacy.post_weight;
+        record->treatment_time = legacy.treatment_time;
+        record->delta_selection = legacy.delta_selection;
+        record->timestamp = legacy.timestamp;
+        record->is_complete = legacy.is_complete;
+        return true;
+    }
+
+    if (length != RECORD_ENCODED_SIZE || in[0] != RECORD_CODEC_VERSION) {
+        return false;
+    }
+
+    record->pre_weight = get_u16(&in[1]);
+    record->dry_weight = get_u16(&in[3]);
+    record->post_weight = get_u16(&in[5]);
+    record_unpack_flags(in[7], record);
+    record->timestamp = (time_t)get_u32(&in[8]);
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "treatment_data.h"
+
+// On-flash encoding of a TreatmentRecord. Explicit little-endian and
+// padding-free so the stored layout does not depend on the compiler ABI.
+//
+//   offset  size  field
+//   0       1     version (RECORD_CODEC_VERSION)
+//   1       2     pre_weight  (u16, x10 kg)
+//   3       2     dry_weight  (u16, x10 kg)
+//   5       2     post_weight (u16, x10 kg)
+//   7       1     bits 0-5: treatment_time / 15 min
+//                 bit 6:    delta_selection
+//                 bit 7:    is_complete
+//   8       4     timestamp (u32, unix seconds)
+
+#define RECORD_CODEC_VERSION     1
+#define RECORD_ENCODED_SIZE      12
+#define RECORD_TIME_STEP_MINUTES 15
+
+// TreatmentRecord as releases before the codec wrote it, raw. Frozen here
+// so that adding a field to TreatmentRecord does not stop these blobs
+// (recognised by their size) from being read.
+typedef struct {
+    int32_t pre_weight;
+    int32_t dry_weight;
+    int32_t post_weight;
+    int16_t treatment_time;
+    int16_t delta_selection;
+    time_t  timestamp;
+    bool    is_complete;
+} LegacyRecord;
+
+// Largest blob record_decode() accepts, including the legacy raw struct
+#define RECORD_MAX_STORED_SIZE   (sizeof(LegacyRecord) > RECORD_ENCODED_SIZE ? \
+                                  sizeof(LegacyRecord) : RECORD_ENCODED_SIZE)
+
+// Byte 7 of the encoding, shared with the compressed history log
+uint8_t record_pack_flags(const TreatmentRecord *record);
+void record_unpack_flags(uint8_t flags, TreatmentRecord *record);
+
+// Encode into out (RECORD_ENCODED_SIZE bytes); returns bytes written
+int record_encode(const TreatmentRecord *record, uint8_t *out);
+
+// Decode a stored blob. Also accepts the raw LegacyRecord blobs
+// written by earlier releases. Returns false on unknown version or length.
+bool record_decode(const uint8_t *in, size_t length, TreatmentRecord *record);
@@ -1,101 +1,1133 @@
 #include "storage.h"
+#include "../debug/trace.h"
 
-#define TREATMENT_RECORD_SIZE sizeof(TreatmentRecord)
+// Active backend and I/O counters
+static const StorageBackend *s_backend = NULL;
+static StorageStats s_stats;
+
+// In-progress key layout, described with the in-progress functions below
+#define UI_SNAPSHOT_OFFSET  RECORD_ENCODED_SIZE
+#define UI_SNAPSHOT_SIZE    2
+#define IN_PROGRESS_SIZE    (RECORD_ENCODED_SIZE + UI_SNAPSHOT_SIZE)
+#define UI_EDITING_BIT      0x80
+
+// Current UI snapshot, included in every in-progress write
+static UiSnapshot s_ui;
+
+// Bytes the in-progress key is known to hold, so unchanged saves are skipped
+static uint8_t s_stored[IN_PROGRESS_SIZE];
+static bool s_stored_valid = false;
+
+// Live log layout, rebuilt from the page headers on first access
+typedef struct {
+    bool recovered;
+    uint8_t head_slot;                              // Slot of the oldest page
+    uint8_t page_count;                             // Live pages from head_slot on
+    uint8_t page_counts[HISTORY_LOG_MAX_PAGES];     // Records per page, by slot
+    uint8_t stale_pages;                            // Bit per slot: older page format
+    uint32_t next_seq;                              // Sequence number of the next record
+} LogIndex;
+
+static LogIndex s_log;
+
+// RAM copy of the history aggregate, read on first use
+static HistoryStats s_history_stats;
+static bool s_history_stats_loaded = false;
+
+// RAM copy of the trend state, read on first use
+static TrendState s_trend;
+static bool s_trend_loaded = false;
+
+// RAM copy of the history index, read on first use
+static HistoryIndex s_index;
+static bool s_index_loaded = false;
+
+static const StorageBackend *backend(void) {
+    if (!s_backend) {
+        s_backend = storage_backend_persist();
+    }
+    return s_backend;
+}
+
+// ---------------------------------------------------------------------------
+// Counted I/O helpers - every backend access in this file goes through these
+// ---------------------------------------------------------------------------
+
+static bool io_exists(uint32_t key) {
+    TRACE(TRACE_STORAGE_EXISTS, key);
+    s_stats.exists_calls++;
+    return backend()->exists(key);
+}
+
+static int io_read_data(uint32_t key, void *buffer, size_t size) {
+    TRACE(TRACE_STORAGE_READ, key);
+    s_stats.read_calls++;
+    int bytes = backend()->read_data(key, buffer, size);
+    if (bytes > 0) {
+        s_stats.bytes_read += bytes;
+    }
+    return bytes;
+}
+
+static int io_write_data(uint32_t key, const void *data, size_t size) {
+    TRACE(TRACE_STORAGE_WRITE, key);
+    s_stats.write_calls++;
+    int bytes = backend()->write_data(key, data, size);
+    if (bytes > 0) {
+        s_stats.bytes_written += bytes;
+    }
+    TRACE_COUNT(TRACE_COUNTER_FLASH_WRITES, 1);
+    TRACE_COUNT(TRACE_COUNTER_BYTES_WRITTEN, bytes > 0 ? bytes : 0);
+    return bytes;
+}
+
+// Read of log bookkeeping rather than records: page headers and the
+// derived state. Once the log is open these are served from RAM.
+static int io_read_metadata(uint32_t key, void *buffer, size_t size) {
+    s_stats.metadata_reads++;
+    return io_read_data(key, buffer, size);
+}
+
+static int32_t io_read_int(uint32_t key) {
+    TRACE(TRACE_STORAGE_READ, key);
+    s_stats.read_calls++;
+    s_stats.bytes_read += sizeof(int32_t);
+    return backend()->read_int(key);
+}
+
+static void io_delete(uint32_t key) {
+    TRACE(TRACE_STORAGE_DELETE, key);
+    TRACE_COUNT(TRACE_COUNTER_FLASH_WRITES, 1);
+    s_stats.delete_calls++;
+    backend()->remove(key);
+}
+
+// Select the backend used by all storage functions
+void storage_set_backend(const StorageBackend *new_backend) {
+    s_backend = new_backend;
+    s_stored_valid = false;
+    s_log.recovered = false;
+    s_history_stats_loaded = false;
+    s_trend_loaded = false;
+    s_index_loaded = false;
+}
+
+const StorageStats *storage_get_stats(void) {
+    return &s_stats;
+}
+
+void storage_reset_stats(void) {
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+// ---------------------------------------------------------------------------
+// In-progress treatment - the encoded record followed by the UI snapshot:
+//
+//   offset  size  field
+//   0       12    record (record_codec.h)
+//   12      1     screen (UiScreen)
+//   13      1     bits 0-6: active field, bit 7: editing
+// ---------------------------------------------------------------------------
+
+static void encode_ui(const UiSnapshot *ui, uint8_t *out) {
+    out[0] = ui->screen;
+    out[1] = (ui->active_field & ~UI_EDITING_BIT) | (ui->editing ? UI_EDITING_BIT : 0);
+}
+
+static void decode_ui(const uint8_t *in, UiSnapshot *ui) {
+    ui->screen = in[0];
+    ui->active_field = in[1] & ~UI_EDITING_BIT;
+    ui->editing = (in[1] & UI_EDITING_BIT) != 0;
+}
+
+static void encode_in_progress(const TreatmentRecord *record, uint8_t *out) {
+    record_encode(record, out);
+    encode_ui(&s_ui, &out[UI_SNAPSHOT_OFFSET]);
+}
+
+static bool write_in_progress(const uint8_t *blob) {
+    if (s_stored_valid && memcmp(blob, s_stored, IN_PROGRESS_SIZE) == 0) {
+        s_stats.skipped_writes++;
+        return true;
+    }
+    if (io_write_data(STORAGE_KEY_IN_PROGRESS, blob, IN_PROGRESS_SIZE) != IN_PROGRESS_SIZE) {
+        s_stored_valid = false;
+        return false;
+    }
+    memcpy(s_stored, blob, IN_PROGRESS_SIZE);
+    s_stored_valid = true;
+    return true;
+}
 
 // Check if in-progress treatment exists
 bool storage_has_in_progress(void) {
-    return persist_exists(STORAGE_KEY_IN_PROGRESS);
+    return io_exists(STORAGE_KEY_IN_PROGRESS);
+}
+
+// ---------------------------------------------------------------------------
+// Write-behind for in-progress saves
+// ---------------------------------------------------------------------------
+
+static uint8_t s_pending[IN_PROGRESS_SIZE];
+static bool s_pending_dirty = false;
+static AppTimer *s_flush_timer = NULL;
+
+static void cancel_pending_save(void) {
+    if (s_flush_timer) {
+        app_timer_cancel(s_flush_timer);
+        s_flush_timer = NULL;
+    }
+    s_pending_dirty = false;
+}
+
+static void flush_timer_callback(void *context) {
+    s_flush_timer = NULL;
+    storage_flush_in_progress();
+}
+
+static void queue_pending_save(void) {
+    if (s_pending_dirty) {
+        s_stats.coalesced_writes++;
+    }
+    s_pending_dirty = true;
+
+    if (!s_flush_timer || !app_timer_reschedule(s_flush_timer, STORAGE_WRITE_BEHIND_MS)) {
+        s_flush_timer = app_timer_register(STORAGE_WRITE_BEHIND_MS, flush_timer_callback, NULL);
+    }
 }
 
 // Save in-progress treatment
 bool storage_save_in_progress(const TreatmentRecord *record) {
-    int bytes = persist_write_data(STORAGE_KEY_IN_PROGRESS,
-                                   record,
-                                   TREATMENT_RECORD_SIZE);
-    return bytes == (int)TREATMENT_RECORD_SIZE;
+    TRACE(TRACE_STORAGE_SAVE_IN_PROGRESS, 0);
+    // A direct save supersedes anything still queued
+    cancel_pending_save();
+
+    uint8_t blob[IN_PROGRESS_SIZE];
+    encode_in_progress(record, blob);
+    return write_in_progress(blob);
 }
 
-// Load in-progress treatment
-bool storage_load_in_progress(TreatmentRecord *record) {
-    if (!persist_exists(STORAGE_KEY_IN_PROGRESS)) {
+// Queue an in-progress save; repeated calls within STORAGE_WRITE_BEHIND_MS
+// of each other collapse into one write
+void storage_save_in_progress_deferred(const TreatmentRecord *record) {
+    TRACE(TRACE_STORAGE_SAVE_DEFERRED, 0);
+    encode_in_progress(record, s_pending);
+    queue_pending_save();
+}
+
+void storage_save_ui_deferred(const UiSnapshot *ui) {
+    TRACE(TRACE_STORAGE_SAVE_UI, 0);
+    s_ui = *ui;
+    if (s_pending_dirty) {
+        encode_ui(&s_ui, &s_pending[UI_SNAPSHOT_OFFSET]);
+        return;
+    }
+
+    // Nothing queued: patch the stored record, if there is one
+    uint8_t encoded[UI_SNAPSHOT_SIZE];
+    encode_ui(&s_ui, encoded);
+    if (!s_stored_valid || memcmp(encoded, &s_stored[UI_SNAPSHOT_OFFSET], UI_SNAPSHOT_SIZE) == 0) {
+        return;
+    }
+    memcpy(s_pending, s_stored, IN_PROGRESS_SIZE);
+    memcpy(&s_pending[UI_SNAPSHOT_OFFSET], encoded, UI_SNAPSHOT_SIZE);
+    queue_pending_save();
+}
+
+const UiSnapshot *storage_get_ui_snapshot(void) {
+    return &s_ui;
+}
+
+// Write the queued in-progress save, if any
+void storage_flush_in_progress(void) {
+    if (!s_pending_dirty) {
+        return;
+    }
+    TRACE(TRACE_STORAGE_FLUSH, 0);
+    uint8_t blob[IN_PROGRESS_SIZE];
+    memcpy(blob, s_pending, IN_PROGRESS_SIZE);
+    cancel_pending_save();
+    write_in_progress(blob);
+}
+
+// Load in-progress treatment. A missing key fails the read, so this is a
+// single backend call.
+bool storage_load_in_progress(TreatmentRecord *record, UiSnapshot *ui) {
+    TRACE(TRACE_STORAGE_LOAD_IN_PROGRESS, 0);
+    uint8_t buffer[RECORD_MAX_STORED_SIZE > IN_PROGRESS_SIZE ? RECORD_MAX_STORED_SIZE : IN_PROGRESS_SIZE];
+    int bytes = io_read_data(STORAGE_KEY_IN_PROGRESS, buffer, sizeof(buffer));
+
+    memset(&s_ui, 0, sizeof(s_ui));
+    if (bytes == IN_PROGRESS_SIZE) {
+        if (!record_decode(buffer, RECORD_ENCODED_SIZE, record)) {
+            return false;
+        }
+        decode_ui(&buffer[UI_SNAPSHOT_OFFSET], &s_ui);
+        memcpy(s_stored, buffer, IN_PROGRESS_SIZE);
+        s_stored_valid = true;
+    } else if (bytes <= 0 || !record_decode(buffer, bytes, record)) {
         return false;
     }
-    int bytes = persist_read_data(STORAGE_KEY_IN_PROGRESS,
-                                  record,
-                                  TREATMENT_RECORD_SIZE);
-    return bytes == (int)TREATMENT_RECORD_SIZE;
+    *ui = s_ui;
+    return true;
 }
 
 // Clear in-progress when treatment completes
 void storage_clear_in_progress(void) {
-    persist_delete(STORAGE_KEY_IN_PROGRESS);
+    TRACE(TRACE_STORAGE_CLEAR_IN_PROGRESS, 0);
+    cancel_pending_save();
+    io_delete(STORAGE_KEY_IN_PROGRESS);
+    s_stored_valid = false;
+}
+
+// ---------------------------------------------------------------------------
+// History log - delta-compressed pages (history_log.h) in a ring of
+// HISTORY_LOG_MAX_PAGES persist keys. Writing a page is the only commit
+// step of an append; which slots are live is recovered from the page
+// headers rather than stored, so there is no second key to fall out of step.
+// ---------------------------------------------------------------------------
+
+// Derived state is stamped with the log's next_seq when written. A stamp
+// that does not match means a reset hit between the page commit and the
+// derived write, and the state is rebuilt from the log. Stats also record
+// the live count, which changes without next_seq if a page is lost.
+typedef struct {
+    uint32_t seq;
+    uint32_t count;
+    HistoryStats stats;
+} StoredStats;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t reserved;
+    TrendState trend;
+} StoredTrend;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t count;
+    HistoryIndex index;
+} StoredIndex;
+
+// Shared page buffer (kept off the small app stack)
+static LogPage s_log_page;
+
+static uint32_t page_key(int slot) {
+    return STORAGE_KEY_LOG_PAGE_BASE + slot;
+}
+
+// Slot of the i-th live page, oldest first
+static int live_slot(int i) {
+    return (s_log.head_slot + i) % HISTORY_LOG_MAX_PAGES;
+}
+
+static int log_record_count(void) {
+    int count = 0;
+    for (int i = 0; i < s_log.page_count; i++) {
+        count += s_log.page_counts[live_slot(i)];
+    }
+    return count;
+}
+
+static bool read_log_page(int slot, LogPage *page) {
+    int bytes = io_read_data(page_key(slot), page->data, HISTORY_LOG_PAGE_SIZE);
+    return bytes > 0 && history_log_page_parse(page, bytes);
+}
+
+static bool write_log_page(int slot, const LogPage *page) {
+    int bytes = io_write_data(page_key(slot), page->data, page->length);
+    if (bytes != page->length) {
+        return false;
+    }
+    s_log.page_counts[slot] = page->count;
+    s_log.stale_pages &= ~(1 << slot);
+    return true;
+}
+
+// Slot a new tail page goes to. Once all slots are live this is the head,
+// which the new page evicts.
+static int next_page_slot(void) {
+    if (s_log.page_count == 0) {
+        return s_log.head_slot;
+    }
+    return live_slot(s_log.page_count);
+}
+
+// Account for a page just written to next_page_slot()
+static void advance_tail(void) {
+    if (s_log.page_count == HISTORY_LOG_MAX_PAGES) {
+        s_log.head_slot = (s_log.head_slot + 1) % HISTORY_LOG_MAX_PAGES;
+    } else {
+        s_log.page_count++;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Import of the fixed 15-entry ring written by earlier releases: one
+// 12-byte record per slot in a single page, or before that one key per slot
+// ---------------------------------------------------------------------------
+
+static bool read_legacy_record(const uint8_t *page, bool paged, int slot, TreatmentRecord *record) {
+    if (paged) {
+        return record_decode(&page[slot * RECORD_ENCODED_SIZE], RECORD_ENCODED_SIZE, record);
+    }
+    uint8_t legacy[RECORD_MAX_STORED_SIZE];
+    int bytes = io_read_data(STORAGE_KEY_HISTORY_BASE + slot, legacy, sizeof(legacy));
+    return bytes > 0 && record_decode(legacy, bytes, record);
+}
+
+static void migrate_legacy_ring(void) {
+    int count = io_read_int(STORAGE_KEY_HISTORY_COUNT);
+    int available = (count < LEGACY_RING_ENTRIES) ? count : LEGACY_RING_ENTRIES;
+    int page_size = LEGACY_RING_ENTRIES * RECORD_ENCODED_SIZE;
+
+    uint8_t *legacy_page = malloc(page_size);
+    bool paged = legacy_page &&
+                 io_read_data(STORAGE_KEY_HISTORY_PAGE_BASE, legacy_page, page_size) == page_size;
+
+    bool written = true;
+    history_log_page_init(&s_log_page, s_log.next_seq);
+    for (int i = 0; i < available; i++) {
+        // Oldest entry is at (count % LEGACY_RING_ENTRIES) once the ring wrapped
+        int slot = (count <= LEGACY_RING_ENTRIES) ? i : (count + i) % LEGACY_RING_ENTRIES;
+        TreatmentRecord record;
+        if (!read_legacy_record(legacy_page, paged, slot, &record)) {
+            continue;
+        }
+        if (!history_log_page_append(&s_log_page, &record)) {
+            written &= write_log_page(next_page_slot(), &s_log_page);
+            advance_tail();
+            history_log_page_init(&s_log_page, s_log.next_seq);
+            history_log_page_append(&s_log_page, &record);
+        }
+        s_log.next_seq++;
+    }
+    free(legacy_page);
+
+    if (s_log_page.count > 0) {
+        written &= write_log_page(next_page_slot(), &s_log_page);
+        advance_tail();
+    }
+    if (!written) {
+        return;
+    }
+
+    // The log now owns the history; drop the old keys
+    io_delete(STORAGE_KEY_HISTORY_PAGE_BASE);
+    for (int slot = 0; slot < LEGACY_RING_ENTRIES; slot++) {
+        uint32_t key = STORAGE_KEY_HISTORY_BASE + slot;
+        if (io_exists(key)) {
+            io_delete(key);
+        }
+    }
+    io_delete(STORAGE_KEY_HISTORY_COUNT);
+}
+
+// ---------------------------------------------------------------------------
+// Recovery - find the live pages after a restart. The tail is the page
+// with the highest first_seq whose CRC checks out (a reset can only damage
+// the page being written, so this normally takes one full read); the head
+// is found by walking back while each page ends where the next one starts.
+// Costs HISTORY_LOG_MAX_PAGES header reads plus one page read, whatever
+// format the pages are in.
+// ---------------------------------------------------------------------------
+
+static void schedule_migration(void);
+
+// The stats, trend and index keys were written by the release that wrote
+// the older pages, before its records were upgraded; rebuild them from the
+// upgraded records on first use
+static void drop_derived(void) {
+    io_delete(STORAGE_KEY_HISTORY_STATS);
+    io_delete(STORAGE_KEY_TREND);
+    io_delete(STORAGE_KEY_HISTORY_INDEX);
+}
+
+static void recover_log(void) {
+    uint32_t first_seq[HISTORY_LOG_MAX_PAGES];
+    uint8_t counts[HISTORY_LOG_MAX_PAGES];
+    bool valid[HISTORY_LOG_MAX_PAGES];
+    bool current[HISTORY_LOG_MAX_PAGES];
+
+    memset(&s_log, 0, sizeof(s_log));
+    s_log.recovered = true;
+
+    for (int slot = 0; slot < HISTORY_LOG_MAX_PAGES; slot++) {
+        uint8_t header[HISTORY_LOG_HEADER_SIZE];
+        int bytes = io_read_metadata(page_key(slot), header, sizeof(header));
+        valid[slot] = bytes == sizeof(header) &&
+                      history_log_header_decode(header, bytes, &first_seq[slot], &counts[slot]) &&
+                      counts[slot] > 0;
+        current[slot] = valid[slot] && history_log_header_is_current(header);
+    }
+
+    int tail = -1;
+    while (true) {
+        tail = -1;
+        for (int slot = 0; slot < HISTORY_LOG_MAX_PAGES; slot++) {
+            if (valid[slot] && (tail < 0 || first_seq[slot] > first_seq[tail])) {
+                tail = slot;
+            }
+        }
+        if (tail < 0 || read_log_page(tail, &s_log_page)) {
+            break;
+        }
+        valid[tail] = false;
+    }
+
+    if (tail < 0) {
+        // No log yet; import the legacy ring if there is one
+        if (io_exists(STORAGE_KEY_HISTORY_COUNT)) {
+            migrate_legacy_ring();
+        }
+        return;
+    }
+
+    int head = tail;
+    s_log.page_count = 1;
+    s_log.page_counts[tail] = s_log_page.count;
+    while (s_log.page_count < HISTORY_LOG_MAX_PAGES) {
+        int prev = (head + HISTORY_LOG_MAX_PAGES - 1) % HISTORY_LOG_MAX_PAGES;
+        if (!valid[prev] || first_seq[prev] + counts[prev] != first_seq[head]) {
+            break;
+        }
+        head = prev;
+        s_log.page_counts[prev] = counts[prev];
+        s_log.page_count++;
+    }
+    s_log.head_slot = head;
+    s_log.next_seq = s_log_page.first_seq + s_log_page.count;
+
+    for (int i = 0; i < s_log.page_count; i++) {
+        if (!current[live_slot(i)]) {
+            s_log.stale_pages |= 1 << live_slot(i);
+        }
+    }
+    if (s_log.stale_pages) {
+        drop_derived();
+        schedule_migration();
+    }
+}
+
+static void ensure_log(void) {
+    if (!s_log.recovered) {
+        recover_log();
+    }
 }
 
 // Get number of history entries
 int storage_get_history_count(void) {
-    if (!persist_exists(STORAGE_KEY_HISTORY_COUNT)) {
-        return 0;
-    }
-    return persist_read_int(STORAGE_KEY_HISTORY_COUNT);
+    TRACE(TRACE_STORAGE_HISTORY_COUNT, 0);
+    ensure_log();
+    return log_record_count();
 }
 
-// Save completed treatment to history (circular buffer)
-bool storage_save_to_history(const TreatmentRecord *record) {
-    int count = storage_get_history_count();
-    int index = count % MAX_HISTORY_ENTRIES;  // Wrap around
+uint32_t storage_get_history_next_seq(void) {
+    ensure_log();
+    return s_log.next_seq;
+}
+
+// ---------------------------------------------------------------------------
+// History statistics - a running aggregate kept next to the log
+// ---------------------------------------------------------------------------
 
-    uint32_t key = STORAGE_KEY_HISTORY_BASE + index;
-    int bytes = persist_write_data(key, record, TREATMENT_RECORD_SIZE);
+typedef void (*RecordVisitor)(void *context, const TreatmentRecord *record);
 
-    if (bytes == (int)TREATMENT_RECORD_SIZE) {
-        // Only increment count up to MAX_HISTORY_ENTRIES
-        // After that, we overwrite oldest entries
-        if (count < MAX_HISTORY_ENTRIES) {
-            persist_write_int(STORAGE_KEY_HISTORY_COUNT, count + 1);
-        } else {
-            // Keep incrementing to track position in circular buffer
-            persist_write_int(STORAGE_KEY_HISTORY_COUNT, count + 1);
+// Feed every live record to visit, oldest first
+static void scan_log(RecordVisitor visit, void *context) {
+    for (int i = 0; i < s_log.page_count; i++) {
+        if (!read_log_page(live_slot(i), &s_log_page)) {
+            continue;
+        }
+        LogCursor cursor;
+        TreatmentRecord record;
+        history_log_cursor_init(&cursor, &s_log_page);
+        while (history_log_cursor_next(&cursor, &record)) {
+            visit(context, &record);
         }
-        return true;
     }
-    return false;
 }
 
-// Load treatment from history by index (0 = oldest available)
-bool storage_load_from_history(int index, TreatmentRecord *record) {
-    int count = storage_get_history_count();
+static bool write_history_stats(const HistoryStats *stats) {
+    s_history_stats = *stats;
+    s_history_stats_loaded = true;
+    StoredStats stored = { .seq = s_log.next_seq, .count = log_record_count(), .stats = *stats };
+    return io_write_data(STORAGE_KEY_HISTORY_STATS, &stored, sizeof(stored)) == (int)sizeof(stored);
+}
+
+static void visit_stats_add(void *context, const TreatmentRecord *record) {
+    history_stats_add((HistoryStats *)context, record);
+}
+
+static void visit_stats_extremes(void *context, const TreatmentRecord *record) {
+    history_stats_include_extremes((HistoryStats *)context, record);
+}
 
-    if (index < 0 || index >= count || index >= MAX_HISTORY_ENTRIES) {
+// Read the aggregate once, rebuilding it from the log if it is missing or
+// stale; later calls are served from RAM
+static void load_history_stats(HistoryStats *stats) {
+    if (s_history_stats_loaded) {
+        *stats = s_history_stats;
+        return;
+    }
+    StoredStats stored;
+    if (io_read_metadata(STORAGE_KEY_HISTORY_STATS, &stored, sizeof(stored)) == (int)sizeof(stored) &&
+        stored.seq == s_log.next_seq && stored.count == (uint32_t)log_record_count()) {
+        s_history_stats = stored.stats;
+        s_history_stats_loaded = true;
+        *stats = stored.stats;
+        return;
+    }
+    history_stats_init(stats);
+    scan_log(visit_stats_add, stats);
+    write_history_stats(stats);
+}
+
+// Subtract the records of the page about to be evicted. Returns true if
+// the minimum or maximum went with it.
+static bool evict_page(int slot, HistoryStats *stats) {
+    bool extremes_lost = false;
+    if (!read_log_page(slot, &s_log_page)) {
         return false;
     }
+    LogCursor cursor;
+    TreatmentRecord record;
+    history_log_cursor_init(&cursor, &s_log_page);
+    while (history_log_cursor_next(&cursor, &record)) {
+        extremes_lost |= history_stats_remove(stats, &record);
+    }
+    return extremes_lost;
+}
+
+// ---------------------------------------------------------------------------
+// Trends - kept in RAM after the first read so the UI can query them freely
+// ---------------------------------------------------------------------------
+
+static void visit_trend_add(void *context, const TreatmentRecord *record) {
+    trend_add((TrendState *)context, record);
+}
+
+static bool write_trend(const TrendState *trend) {
+    StoredTrend stored = { .seq = s_log.next_seq, .trend = *trend };
+    return io_write_data(STORAGE_KEY_TREND, &stored, sizeof(stored)) == (int)sizeof(stored);
+}
 
-    // Calculate actual storage index
-    int actual_index;
-    if (count <= MAX_HISTORY_ENTRIES) {
-        actual_index = index;
+static void load_trend(void) {
+    if (s_trend_loaded) {
+        return;
+    }
+    StoredTrend stored;
+    if (io_read_metadata(STORAGE_KEY_TREND, &stored, sizeof(stored)) == (int)sizeof(stored) &&
+        stored.seq == s_log.next_seq) {
+        s_trend = stored.trend;
     } else {
-        // Circular buffer: oldest entry is at (count % MAX_HISTORY_ENTRIES)
-        actual_index = (count + index) % MAX_HISTORY_ENTRIES;
+        trend_init(&s_trend);
+        scan_log(visit_trend_add, &s_trend);
+        write_trend(&s_trend);
     }
+    s_trend_loaded = true;
+}
+
+const TrendState *storage_get_trend(void) {
+    TRACE(TRACE_STORAGE_GET_TREND, 0);
+    ensure_log();
+    load_trend();
+    return &s_trend;
+}
 
-    uint32_t key = STORAGE_KEY_HISTORY_BASE + actual_index;
+// ---------------------------------------------------------------------------
+// History index - week buckets for date-range queries, kept in RAM like the
+// trend
+// ---------------------------------------------------------------------------
+
+// Sequence number of the oldest live record
+static uint32_t oldest_seq(void) {
+    return s_log.next_seq - log_record_count();
+}
+
+typedef struct {
+    HistoryIndex *index;
+    uint32_t seq;
+} IndexBuild;
+
+static void visit_index_add(void *context, const TreatmentRecord *record) {
+    IndexBuild *build = (IndexBuild *)context;
+    history_index_add(build->index, record, build->seq++);
+}
 
-    if (!persist_exists(key)) {
+static bool write_index(const HistoryIndex *index) {
+    StoredIndex stored = { .seq = s_log.next_seq, .count = log_record_count(), .index = *index };
+    return io_write_data(STORAGE_KEY_HISTORY_INDEX, &stored, sizeof(stored)) == (int)sizeof(stored);
+}
+
+static void rebuild_index(void) {
+    IndexBuild build = { .index = &s_index, .seq = oldest_seq() };
+    history_index_init(&s_index, build.seq);
+    scan_log(visit_index_add, &build);
+}
+
+static void load_index(void) {
+    if (s_index_loaded) {
+        return;
+    }
+    StoredIndex stored;
+    if (io_read_metadata(STORAGE_KEY_HISTORY_INDEX, &stored, sizeof(stored)) == (int)sizeof(stored) &&
+        stored.seq == s_log.next_seq && stored.count == (uint32_t)log_record_count()) {
+        s_index = stored.index;
+    } else {
+        rebuild_index();
+        write_index(&s_index);
+    }
+    s_index_loaded = true;
+}
+
+const HistoryIndex *storage_get_history_index(void) {
+    ensure_log();
+    load_index();
+    return &s_index;
+}
+
+// ---------------------------------------------------------------------------
+// Appends - records go into the tail page in RAM, which is written when it
+// fills and at the end, so a batch writes each page once. Stats, trend and
+// index are updated in RAM per record and written once per batch.
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    HistoryStats stats;
+    bool extremes_lost;         // Eviction took the min or max
+    bool failed;                // A page write failed
+    int slot;                   // Slot s_log_page is written to
+    bool new_page;              // s_log_page is not live yet
+    uint8_t committed;          // Records of s_log_page already written
+    uint32_t next_seq;          // Sequence number of the next record appended
+} AppendBatch;
+
+// Start the next page, evicting the oldest when the log is full
+static void start_page(AppendBatch *batch) {
+    batch->slot = next_page_slot();
+    if (s_log.page_count == HISTORY_LOG_MAX_PAGES) {
+        batch->extremes_lost |= evict_page(batch->slot, &batch->stats);
+    }
+    history_log_page_init(&s_log_page, batch->next_seq);
+    batch->new_page = true;
+    batch->committed = 0;
+}
+
+static void append_begin(AppendBatch *batch) {
+    ensure_log();
+    load_trend();
+    load_index();
+    load_history_stats(&batch->stats);
+    batch->extremes_lost = false;
+    batch->failed = false;
+    batch->next_seq = s_log.next_seq;
+
+    // Read-modify-write the tail page, or start the next one
+    batch->slot = live_slot(s_log.page_count - 1);
+    batch->new_page = false;
+    if (s_log.page_count == 0 || !read_log_page(batch->slot, &s_log_page)) {
+        start_page(batch);
+    } else {
+        batch->committed = s_log_page.count;
+    }
+}
+
+// Commit point: write s_log_page if it holds records not yet written
+static bool commit_page(AppendBatch *batch) {
+    if (s_log_page.count == batch->committed) {
+        return true;
+    }
+    if (!write_log_page(batch->slot, &s_log_page)) {
+        batch->failed = true;
         return false;
     }
+    if (batch->new_page) {
+        advance_tail();
+        batch->new_page = false;
+    }
+    s_log.next_seq = batch->next_seq;
+    batch->committed = s_log_page.count;
+    return true;
+}
+
+static bool append_record(AppendBatch *batch, const TreatmentRecord *record) {
+    if (!history_log_page_append(&s_log_page, record)) {
+        if (!commit_page(batch)) {
+            return false;
+        }
+        start_page(batch);
+        history_log_page_append(&s_log_page, record);
+    }
+    history_stats_add(&batch->stats, record);
+    trend_add(&s_trend, record);
+    history_index_add(&s_index, record, batch->next_seq);
+    batch->next_seq++;
+    return true;
+}
+
+// Write the last page and the derived state; false only if a page was not
+// written (the records are then not stored)
+static bool append_end(AppendBatch *batch) {
+    if (batch->failed || !commit_page(batch)) {
+        // RAM copies counted records that did not make it; reload them
+        s_history_stats_loaded = false;
+        s_trend_loaded = false;
+        s_index_loaded = false;
+        return false;
+    }
+
+    // Min and max are recomputed from the remaining pages only when
+    // eviction took them, at most once per page rollover
+    if (batch->extremes_lost) {
+        history_stats_reset_extremes(&batch->stats);
+        scan_log(visit_stats_extremes, &batch->stats);
+    }
+    if (history_index_evict(&s_index, oldest_seq())) {
+        rebuild_index();
+    }
+
+    // Best effort: a missed write is caught by its stamp on the next load,
+    // so it does not fail an append that is already committed
+    write_history_stats(&batch->stats);
+    write_trend(&s_trend);
+    write_index(&s_index);
+    return true;
+}
+
+// Append a completed treatment to the log
+bool storage_save_to_history(const TreatmentRecord *record) {
+    TRACE(TRACE_STORAGE_SAVE_HISTORY, 0);
+    AppendBatch batch;
+    append_begin(&batch);
+
+    // A reset after the commit but before in-progress was cleared makes the
+    // same treatment come back; saving it again must not duplicate it
+    if (!batch.new_page && s_log_page.count > 0 && treatment_records_equal(&s_log_page.last, record)) {
+        return true;
+    }
 
-    int bytes = persist_read_data(key, record, TREATMENT_RECORD_SIZE);
-    return bytes == (int)TREATMENT_RECORD_SIZE;
+    append_record(&batch, record);
+    return append_end(&batch);
 }
 
-// Clear all history
+int storage_import_history(const TreatmentRecord records[], int n) {
+    TRACE(TRACE_STORAGE_IMPORT_HISTORY, n);
+    AppendBatch batch;
+    append_begin(&batch);
+
+    // Only records newer than everything stored: keeps the log in time
+    // order, and a batch sent twice is stored once
+    uint32_t newest = s_index.last_timestamp;
+    int imported = 0;
+    for (int i = 0; i < n; i++) {
+        if (records[i].timestamp <= (time_t)newest) {
+            continue;
+        }
+        if (!append_record(&batch, &records[i])) {
+            break;
+        }
+        newest = (uint32_t)records[i].timestamp;
+        imported++;
+    }
+
+    append_end(&batch);
+    return batch.failed ? -1 : imported;
+}
+
+// ---------------------------------------------------------------------------
+// Edits - pages are rewritten in place, then the derived state is rebuilt
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    HistoryStats stats;
+    IndexBuild index;
+} DerivedBuild;
+
+static void visit_derived_add(void *context, const TreatmentRecord *record) {
+    DerivedBuild *build = (DerivedBuild *)context;
+    history_stats_add(&build->stats, record);
+    trend_add(&s_trend, record);
+    visit_index_add(&build->index, record);
+}
+
+// Recompute stats, trend and index in one pass over the log
+static void rebuild_derived(void) {
+    DerivedBuild build = { .index = { .index = &s_index, .seq = oldest_seq() } };
+    history_stats_init(&build.stats);
+    trend_init(&s_trend);
+    history_index_init(&s_index, build.index.seq);
+    scan_log(visit_derived_add, &build);
+    s_trend_loaded = true;
+    s_index_loaded = true;
+
+    write_history_stats(&build.stats);
+    write_trend(&s_trend);
+    write_index(&s_index);
+}
+
+// Re-encode the page in slot in the current format, replacing the records
+// first_seq .. first_seq + n - 1 it holds. Returns the number replaced, or
+// -1 if the page could not be read, no longer fits or was not written.
+static int rewrite_page(int slot, LogPage *rewritten, uint32_t first_seq,
+                        const TreatmentRecord records[], int n) {
+    if (!read_log_page(slot, &s_log_page)) {
+        return -1;
+    }
+
+    uint32_t seq = s_log_page.first_seq;
+    uint32_t end_seq = first_seq + n;
+    int updated = 0;
+    history_log_page_init(rewritten, seq);
+    LogCursor cursor;
+    TreatmentRecord record;
+    history_log_cursor_init(&cursor, &s_log_page);
+    while (history_log_cursor_next(&cursor, &record)) {
+        bool edited = seq >= first_seq && seq < end_seq;
+        if (!history_log_page_append(rewritten, edited ? &records[seq - first_seq] : &record)) {
+            return -1;
+        }
+        updated += edited;
+        seq++;
+    }
+    return write_log_page(slot, rewritten) ? updated : -1;
+}
+
+int storage_update_history(uint32_t first_seq, const TreatmentRecord records[], int n) {
+    TRACE(TRACE_STORAGE_UPDATE_HISTORY, first_seq);
+    ensure_log();
+
+    uint32_t seq = oldest_seq();
+    uint32_t end_seq = first_seq + n;
+    if (n <= 0 || first_seq < seq || end_seq > s_log.next_seq) {
+        return 0;
+    }
+
+    LogPage *rewritten = malloc(sizeof(LogPage));
+    if (!rewritten) {
+        return -1;
+    }
+
+    // An edit that no longer fits its page is refused
+    int updated = 0;
+    bool ok = true;
+    for (int i = 0; i < s_log.page_count && ok && seq < end_seq; i++) {
+        int slot = live_slot(i);
+        uint32_t page_end = seq + s_log.page_counts[slot];
+        if (page_end > first_seq) {
+            int replaced = rewrite_page(slot, rewritten, first_seq, records, n);
+            ok = replaced >= 0;
+            updated += ok ? replaced : 0;
+        }
+        seq = page_end;
+    }
+    free(rewritten);
+
+    rebuild_derived();
+    return ok ? updated : -1;
+}
+
+// ---------------------------------------------------------------------------
+// Migration - pages in an older format are read through the upgrades in
+// history_log.c and rewritten in the current one on a timer, a page at a
+// time, so neither startup nor any one tick pays for the whole log
+// ---------------------------------------------------------------------------
+
+static AppTimer *s_migrate_timer = NULL;
+
+static void migrate_timer_callback(void *context) {
+    s_migrate_timer = NULL;
+    if (storage_migrate_step() > 0) {
+        schedule_migration();
+    }
+}
+
+static void schedule_migration(void) {
+    if (!s_migrate_timer) {
+        s_migrate_timer = app_timer_register(STORAGE_MIGRATE_INTERVAL_MS, migrate_timer_callback, NULL);
+    }
+}
+
+static int stale_page_count(void) {
+    int count = 0;
+    for (int slot = 0; slot < HISTORY_LOG_MAX_PAGES; slot++) {
+        count += (s_log.stale_pages >> slot) & 1;
+    }
+    return count;
+}
+
+int storage_migrate_step(void) {
+    ensure_log();
+    int slot = -1;
+    for (int i = 0; i < s_log.page_count && slot < 0; i++) {
+        if (s_log.stale_pages & (1 << live_slot(i))) {
+            slot = live_slot(i);
+        }
+    }
+    if (slot < 0) {
+        return 0;
+    }
+    TRACE(TRACE_STORAGE_MIGRATE_PAGE, slot);
+
+    LogPage *rewritten = malloc(sizeof(LogPage));
+    if (!rewritten) {
+        return stale_page_count();
+    }
+    if (rewrite_page(slot, rewritten, 0, NULL, 0) < 0) {
+        // Unreadable, or grown past a page: left as it is for this launch
+        APP_LOG(APP_LOG_LEVEL_WARNING, "history page %d not rewritten", slot);
+        s_log.stale_pages &= ~(1 << slot);
+    }
+    free(rewritten);
+    return stale_page_count();
+}
+
+// Summary of all stored history with a single read; false if there is none
+bool storage_load_history_stats(HistoryStats *stats) {
+    TRACE(TRACE_STORAGE_LOAD_STATS, 0);
+    ensure_log();
+    load_history_stats(stats);
+    return stats->count > 0;
+}
+
+// Range visitors return false to stop the scan, e.g. once their output is full
+typedef bool (*RangeVisitor)(void *context, const TreatmentRecord *record);
+
+// Feed up to n consecutive live records from start (0 = oldest) to visit,
+// reading each page touched once and no page after visit stops the scan.
+// Returns the number of records visited.
+static int scan_log_range(int start, int n, RangeVisitor visit, void *context) {
+    int available = log_record_count();
+
+    if (start < 0 || n <= 0 || start >= available) {
+        return 0;
+    }
+    if (start + n > available) {
+        n = available - start;
+    }
+
+    // Skip whole pages before start using the per-page counts
+    int page = 0;
+    int index = 0;
+    while (index + s_log.page_counts[live_slot(page)] <= start) {
+        index += s_log.page_counts[live_slot(page)];
+        page++;
+    }
+
+    int visited = 0;
+    bool more = true;
+    while (more && visited < n && page < s_log.page_count) {
+        if (!read_log_page(live_slot(page), &s_log_page)) {
+            break;
+        }
+        LogCursor cursor;
+        TreatmentRecord record;
+        history_log_cursor_init(&cursor, &s_log_page);
+        while (more && visited < n && history_log_cursor_next(&cursor, &record)) {
+            if (index++ >= start) {
+                more = visit(context, &record);
+                visited++;
+            }
+        }
+        page++;
+    }
+    return visited;
+}
+
+typedef struct {
+    TreatmentRecord *out;
+    int loaded;
+    int n;                      // Capacity of out
+    time_t from;                // Timestamp filter (load_between only)
+    time_t to;
+} RecordCopy;
+
+static bool visit_copy(void *context, const TreatmentRecord *record) {
+    RecordCopy *copy = (RecordCopy *)context;
+    copy->out[copy->loaded++] = *record;
+    return true;
+}
+
+// Stops the scan once out is full
+static bool visit_copy_between(void *context, const TreatmentRecord *record) {
+    RecordCopy *copy = (RecordCopy *)context;
+    if (record->timestamp >= copy->from && record->timestamp < copy->to) {
+        copy->out[copy->loaded++] = *record;
+    }
+    return copy->loaded < copy->n;
+}
+
+// Load up to n consecutive entries starting at start (0 = oldest available).
+// Reads each page touched once; returns the number of records loaded.
+int storage_load_history_range(int start, int n, TreatmentRecord out[]) {
+    TRACE(TRACE_STORAGE_LOAD_HISTORY, start);
+    ensure_log();
+    RecordCopy copy = { .out = out };
+    scan_log_range(start, n, visit_copy, &copy);
+    return copy.loaded;
+}
+
+int storage_load_history_between(time_t from, time_t to, int n, TreatmentRecord out[]) {
+    TRACE(TRACE_STORAGE_LOAD_BETWEEN, from);
+    ensure_log();
+    load_index();
+
+    // Narrow the scan to the sequence numbers of the weeks in range
+    uint32_t first = oldest_seq();
+    uint32_t end = s_log.next_seq;
+    uint32_t span_first;
+    uint32_t span_end;
+    if (history_index_span(&s_index, from, to, &span_first, &span_end)) {
+        first = (span_first > first) ? span_first : first;
+        end = (span_end < end) ? span_end : end;
+    }
+    if (end <= first || n <= 0) {
+        return 0;
+    }
+
+    RecordCopy copy = { .out = out, .n = n, .from = from, .to = to };
+    scan_log_range(first - oldest_seq(), end - first, visit_copy_between, &copy);
+    return copy.loaded;
+}
+
+// Load treatment from history by index (0 = oldest available)
+bool storage_load_from_history(int index, TreatmentRecord *record) {
+    return storage_load_history_range(index, 1, record) == 1;
+}
+
+// Clear all history, including anything left in the legacy layout
 void storage_clear_all_history(void) {
-    int count = storage_get_history_count();
-    int max_to_clear = (count < MAX_HISTORY_ENTRIES) ? count : MAX_HISTORY_ENTRIES;
+    TRACE(TRACE_STORAGE_CLEAR_HISTORY, 0);
+    for (int slot = 0; slot < HISTORY_LOG_MAX_PAGES; slot++) {
+        io_delete(page_key(slot));
+    }
+    io_delete(STORAGE_KEY_HISTORY_STATS);
+    io_delete(STORAGE_KEY_TREND);
+    io_delete(STORAGE_KEY_HISTORY_INDEX);
+    memset(&s_log, 0, sizeof(s_log));
+    s_log.recovered = true;
+    history_stats_init(&s_history_stats);
+    s_history_stats_loaded = true;
+    trend_init(&s_trend);
+    s_trend_loaded = true;
+    history_index_init(&s_index, 0);
+    s_index_loaded = true;
 
-    for (int i = 0; i < max_to_clear; i++) {
-        uint32_t key = STORAGE_KEY_HISTORY_BASE + i;
-        persist_delete(key);
+    io_delete(STORAGE_KEY_HISTORY_PAGE_BASE);
+    for (int slot = 0; slot < LEGACY_RING_ENTRIES; slot++) {
+        io_delete(STORAGE_KEY_HISTORY_BASE + slot);
     }
-    persist_delete(STORAGE_KEY_HISTORY_COUNT);
+    io_delete(STORAGE_KEY_HISTORY_COUNT);
+}
+
+// ---------------------------------------------------------------------------
+// Trace session counters
+// ---------------------------------------------------------------------------
+
+int storage_load_session_counters(void *buffer, size_t size) {
+    return io_read_data(STORAGE_KEY_SESSION_COUNTERS, buffer, size);
+}
+
+bool storage_save_session_counters(const void *data, size_t size) {
+    return io_write_data(STORAGE_KEY_SESSION_COUNTERS, data, size) == (int)size;
 }
@@ -6,23 +6,143 @@
 #include <pebble.h>
 #pragma GCC diagnostic pop
 #include "treatment_data.h"
+#include "storage_backend.h"
+#include "record_codec.h"
+#include "history_log.h"
+#include "history_stats.h"
+#include "history_index.h"
+#include "trend.h"
 
 // Storage key definitions
 #define STORAGE_KEY_IN_PROGRESS      0x0001  // Current in-progress treatment
-#define STORAGE_KEY_HISTORY_COUNT    0x0002  // Number of saved treatments
-#define STORAGE_KEY_HISTORY_BASE     0x0100  // History entries start here
+#define STORAGE_KEY_HISTORY_COUNT    0x0002  // Legacy ring: treatments ever saved
+#define STORAGE_KEY_HISTORY_STATS    0x0004  // Running aggregate over history
+#define STORAGE_KEY_TREND            0x0005  // Weight gain / drift regression sums
+#define STORAGE_KEY_SESSION_COUNTERS 0x0006  // Trace counters (ENABLE_TRACE builds only)
+#define STORAGE_KEY_HISTORY_INDEX    0x0007  // Week buckets over history timestamps
+#define STORAGE_KEY_HISTORY_BASE     0x0100  // Legacy ring: one key per entry
+#define STORAGE_KEY_HISTORY_PAGE_BASE 0x0200 // Legacy ring: single packed page
+#define STORAGE_KEY_LOG_PAGE_BASE    0x0300  // History log pages start here
 
-// Storage limits
-#define MAX_HISTORY_ENTRIES          15      // Circular buffer size
+// Idle time after the last deferred in-progress save before it is written
+#define STORAGE_WRITE_BEHIND_MS      1500
 
-// In-progress treatment functions
+// History is an append-only log of delta-compressed pages. At ~8 bytes per
+// treatment a page holds ~30, so 8 pages (2 KB of the 4 KB persist budget)
+// keep well over a year at three sessions a week. When the log is full the
+// oldest page is evicted as a whole.
+#define HISTORY_LOG_MAX_PAGES        8
+
+// Size of the fixed ring used by earlier releases (imported on first access)
+#define LEGACY_RING_ENTRIES          15
+
+// Pages in an older format (history_log.h) are rewritten one per interval
+// once the log has been opened, after the launch work is done
+#define STORAGE_MIGRATE_INTERVAL_MS  2000
+
+// Screen the user was on, saved with the in-progress treatment so a
+// relaunch lands in the same place
+typedef enum {
+    UI_SCREEN_PRE,
+    UI_SCREEN_POST,
+    UI_SCREEN_SESSION           // Treatment running (session window)
+} UiScreen;
+
+typedef struct {
+    uint8_t screen;             // UiScreen
+    uint8_t active_field;       // Pre-treatment field index
+    bool editing;               // Active field in edit mode
+} UiSnapshot;
+
+// Backend I/O counters, accumulated across all storage_* calls
+typedef struct {
+    uint32_t exists_calls;
+    uint32_t read_calls;
+    uint32_t write_calls;
+    uint32_t delete_calls;
+    uint32_t metadata_reads;    // Reads of page headers and derived state
+    uint32_t bytes_read;
+    uint32_t bytes_written;
+    uint32_t coalesced_writes;  // Deferred saves absorbed by a later one
+    uint32_t skipped_writes;    // Saves identical to what is already stored
+} StorageStats;
+
+// Backend selection (defaults to persist) and instrumentation
+void storage_set_backend(const StorageBackend *backend);
+const StorageStats *storage_get_stats(void);
+void storage_reset_stats(void);
+
+// In-progress treatment functions. The record is stored together with the
+// current UI snapshot; a save that would not change the stored bytes is
+// skipped.
 bool storage_has_in_progress(void);
 bool storage_save_in_progress(const TreatmentRecord *record);
-bool storage_load_in_progress(TreatmentRecord *record);
 void storage_clear_in_progress(void);
 
+// Load the in-progress treatment and the UI snapshot saved with it in one
+// read. ui gets the defaults if the record predates snapshots.
+bool storage_load_in_progress(TreatmentRecord *record, UiSnapshot *ui);
+
+// Write-behind variant for rapid edits (e.g. repeating clicks). Callers must
+// storage_flush_in_progress() before the state can be lost.
+void storage_save_in_progress_deferred(const TreatmentRecord *record);
+void storage_flush_in_progress(void);
+
+// Update the UI snapshot. Queued like a deferred save while a treatment is
+// in progress; otherwise kept for the next save.
+void storage_save_ui_deferred(const UiSnapshot *ui);
+const UiSnapshot *storage_get_ui_snapshot(void);
+
 // History functions
 int storage_get_history_count(void);
+
+// Sequence number the next saved treatment will get. Every stored record
+// has a unique, increasing one (oldest live = next_seq - count).
+uint32_t storage_get_history_next_seq(void);
+
+// Append a completed treatment. Returns true once it is committed to the
+// log (saving the same treatment again is a no-op); on false it is not
+// stored and the caller must keep it.
 bool storage_save_to_history(const TreatmentRecord *record);
+
+// Append records from elsewhere (e.g. the phone), oldest first. Only those
+// newer than every stored treatment are kept, so the log stays in time
+// order and a batch received twice is stored once. Each page is written
+// once per batch. Returns the number appended, or -1 if a write failed.
+int storage_import_history(const TreatmentRecord records[], int n);
+
+// Replace the stored records first_seq .. first_seq + n - 1, rewriting each
+// page once, then rebuild stats, trend and index. Returns the number
+// replaced (0 if any is no longer stored), or -1 if a page could not be
+// rewritten (e.g. the edits no longer fit it).
+int storage_update_history(uint32_t first_seq, const TreatmentRecord records[], int n);
 bool storage_load_from_history(int index, TreatmentRecord *record);
+int storage_load_history_range(int start, int n, TreatmentRecord out[]);
+
+// Load up to n entries with from <= timestamp < to, oldest first. Only the
+// pages of the weeks in range are read (the whole log if timestamps went
+// backwards). Returns the number of records loaded.
+int storage_load_history_between(time_t from, time_t to, int n, TreatmentRecord out[]);
+
+// Week buckets over the stored history (e.g. treatments per week), updated
+// on every save. Read from flash once, then served from RAM.
+const HistoryIndex *storage_get_history_index(void);
+
+// Aggregate over all stored history, maintained on every save. Read from
+// flash once, then served from RAM; returns false if there is no completed
+// treatment.
+bool storage_load_history_stats(HistoryStats *stats);
+
+// Trend state, updated on every save. Read from flash once, then served
+// from RAM.
+const TrendState *storage_get_trend(void);
 void storage_clear_all_history(void);
+
+// Rewrite the oldest live page still in an older format in the current
+// one. Runs on a timer; returns the number of such pages left.
+int storage_migrate_step(void);
+
+// Trace session counters (ENABLE_TRACE builds), through the same counted
+// backend access as everything else. Load returns the bytes read.
+int storage_load_session_counters(void *buffer, size_t size);
+bool storage_save_session_counters(const void *data, size_t size);
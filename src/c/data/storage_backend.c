@@ -0,0 +1,143 @@
+#include "storage_backend.h"
+
+// ---------------------------------------------------------------------------
+// Persist backend
+// ---------------------------------------------------------------------------
+
+static const StorageBackend s_persist_backend = {
+    .exists = persist_exists,
+    .read_data = persist_read_data,
+    .write_data = persist_write_data,
+    .read_int = persist_read_int,
+    .write_int = persist_write_int,
+    .remove = persist_delete
+};
+
+const StorageBackend *storage_backend_persist(void) {
+    return &s_persist_backend;
+}
+
+// ---------------------------------------------------------------------------
+// Memory backend
+// ---------------------------------------------------------------------------
+
+#define MEMORY_BACKEND_MAX_KEYS  32
+
+typedef struct {
+    uint32_t key;
+    uint16_t length;
+    uint8_t *data;          // NULL when the entry is unused
+} MemoryEntry;
+
+// Table itself is allocated lazily so release builds that never touch the
+// memory backend pay nothing for it
+static MemoryEntry *s_entries = NULL;
+
+static MemoryEntry *memory_find(uint32_t key) {
+    if (!s_entries) {
+        return NULL;
+    }
+    for (int i = 0; i < MEMORY_BACKEND_MAX_KEYS; i++) {
+        if (s_entries[i].data && s_entries[i].key == key) {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static MemoryEntry *memory_find_or_create(uint32_t key) {
+    MemoryEntry *entry = memory_find(key);
+    if (entry) {
+        return entry;
+    }
+    if (!s_entries) {
+        s_entries = calloc(MEMORY_BACKEND_MAX_KEYS, sizeof(MemoryEntry));
+        if (!s_entries) {
+            return NULL;
+        }
+    }
+    for (int i = 0; i < MEMORY_BACKEND_MAX_KEYS; i++) {
+        if (!s_entries[i].data) {
+            s_entries[i].data = malloc(PERSIST_DATA_MAX_LENGTH);
+            if (!s_entries[i].data) {
+                return NULL;
+            }
+            s_entries[i].key = key;
+            s_entries[i].length = 0;
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static bool memory_exists(uint32_t key) {
+    return memory_find(key) != NULL;
+}
+
+static int memory_read_data(uint32_t key, void *buffer, size_t size) {
+    MemoryEntry *entry = memory_find(key);
+    if (!entry) {
+        return E_DOES_NOT_EXIST;
+    }
+    size_t n = (size < entry->length) ? size : entry->length;
+    memcpy(buffer, entry->data, n);
+    return (int)n;
+}
+
+static int memory_write_data(uint32_t key, const void *data, size_t size) {
+    if (size > PERSIST_DATA_MAX_LENGTH) {
+        size = PERSIST_DATA_MAX_LENGTH;
+    }
+    MemoryEntry *entry = memory_find_or_create(key);
+    if (!entry) {
+        return E_OUT_OF_STORAGE;
+    }
+    memcpy(entry->data, data, size);
+    entry->length = (uint16_t)size;
+    return (int)size;
+}
+
+static int32_t memory_read_int(uint32_t key) {
+    int32_t value = 0;
+    memory_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+static status_t memory_write_int(uint32_t key, int32_t value) {
+    int bytes = memory_write_data(key, &value, sizeof(value));
+    return (bytes == (int)sizeof(value)) ? S_SUCCESS : E_OUT_OF_STORAGE;
+}
+
+static status_t memory_remove(uint32_t key) {
+    MemoryEntry *entry = memory_find(key);
+    if (!entry) {
+        return E_DOES_NOT_EXIST;
+    }
+    free(entry->data);
+    entry->data = NULL;
+    return S_SUCCESS;
+}
+
+static const StorageBackend s_memory_backend = {
+    .exists = memory_exists,
+    .read_data = memory_read_data,
+    .write_data = memory_write_data,
+    .read_int = memory_read_int,
+    .write_int = memory_write_int,
+    .remove = memory_remove
+};
+
+const StorageBackend *storage_backend_memory(void) {
+    return &s_memory_backend;
+}
+
+void storage_backend_memory_reset(void) {
+    if (!s_entries) {
+        return;
+    }
+    for (int i = 0; i < MEMORY_BACKEND_MAX_KEYS; i++) {
+        free(s_entries[i].data);
+    }
+    free(s_entries);
+    s_entries = NULL;
+}
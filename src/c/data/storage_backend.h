@@ -0,0 +1,27 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+
+// Key/value backend that storage.c performs all of its I/O through.
+// Signatures mirror the Pebble persist API so the persist backend is a
+// direct pass-through.
+typedef struct {
+    bool    (*exists)(uint32_t key);
+    int     (*read_data)(uint32_t key, void *buffer, size_t size);
+    int     (*write_data)(uint32_t key, const void *data, size_t size);
+    int32_t (*read_int)(uint32_t key);
+    status_t (*write_int)(uint32_t key, int32_t value);
+    status_t (*remove)(uint32_t key);
+} StorageBackend;
+
+// Pebble persistent storage (flash) - the default backend
+const StorageBackend *storage_backend_persist(void);
+
+// RAM-only backend for benchmarking and dry runs. Entries are heap
+// allocated on first write and released by storage_backend_memory_reset().
+const StorageBackend *storage_backend_memory(void);
+void storage_backend_memory_reset(void);
@@ -66,3 +66,13 @@ void init_treatment_record(TreatmentRecord *record) {
     // Not complete yet
     record->is_complete = false;
 }
+
+bool treatment_records_equal(const TreatmentRecord *a, const TreatmentRecord *b) {
+    return a->timestamp == b->timestamp &&
+           a->pre_weight == b->pre_weight &&
+           a->dry_weight == b->dry_weight &&
+           a->post_weight == b->post_weight &&
+           a->treatment_time == b->treatment_time &&
+           a->delta_selection == b->delta_selection &&
+           a->is_complete == b->is_complete;
+}
@@ -41,3 +41,6 @@ void calculate_post_metrics(const TreatmentRecord *record, CalculatedMetrics *me
 
 // Initialize a new treatment record with default values
 void init_treatment_record(TreatmentRecord *record);
+
+// Whether two records describe the same treatment (every field equal)
+bool treatment_records_equal(const TreatmentRecord *a, const TreatmentRecord *b);
@@ -0,0 +1,71 @@
+#include "trend.h"
+
+// Move the origin to the new sample (every existing x drops by one), age
+// the existing weights, then add y at x = 0
+static void fit_add(TrendFit *fit, int32_t y) {
+    fit->wxx += fit->w - 2 * fit->wx;
+    fit->wxy -= fit->wy;
+    fit->wx -= fit->w;
+
+    fit->w -= fit->w / TREND_DECAY_DIVISOR;
+    fit->wx -= fit->wx / TREND_DECAY_DIVISOR;
+    fit->wxx -= fit->wxx / TREND_DECAY_DIVISOR;
+    fit->wy -= fit->wy / TREND_DECAY_DIVISOR;
+    fit->wxy -= fit->wxy / TREND_DECAY_DIVISOR;
+
+    fit->w += TREND_WEIGHT_ONE;
+    fit->wy += (int64_t)TREND_WEIGHT_ONE * y;
+}
+
+static int32_t round_div(int64_t numerator, int64_t denominator) {
+    int64_t half = denominator / 2;
+    return (int32_t)((numerator >= 0) ? (numerator + half) / denominator
+                                      : (numerator - half) / denominator);
+}
+
+// Level at x (in y units) and slope per treatment (y units x10). With a
+// single distinct x the slope is 0 and the level is the weighted mean.
+static void fit_solve(const TrendFit *fit, int x, int32_t *level, int32_t *slope_x10) {
+    int64_t det = fit->w * fit->wxx - fit->wx * fit->wx;
+    if (det <= 0) {
+        *level = fit->w ? round_div(fit->wy, fit->w) : 0;
+        *slope_x10 = 0;
+        return;
+    }
+    int64_t slope_num = fit->w * fit->wxy - fit->wx * fit->wy;
+    int64_t intercept_num = fit->wy * fit->wxx - fit->wx * fit->wxy;
+    *level = round_div(intercept_num + x * slope_num, det);
+    *slope_x10 = round_div(slope_num * 10, det);
+}
+
+void trend_init(TrendState *state) {
+    memset(state, 0, sizeof(*state));
+}
+
+void trend_add(TrendState *state, const TreatmentRecord *record) {
+    if (!record->is_complete) {
+        return;
+    }
+    if (state->last_post > 0) {
+        fit_add(&state->gain, record->pre_weight - state->last_post);
+    }
+    fit_add(&state->drift, record->post_weight - record->dry_weight);
+    state->last_post = record->post_weight;
+    if (state->samples < UINT16_MAX) {
+        state->samples++;
+    }
+}
+
+bool trend_summarize(const TrendState *state, int32_t dry_weight, TrendSummary *summary) {
+    if (state->samples < TREND_MIN_SAMPLES) {
+        memset(summary, 0, sizeof(*summary));
+        return false;
+    }
+
+    // Gain is predicted one treatment ahead; drift is the current level
+    fit_solve(&state->gain, 1, &summary->gain, &summary->gain_slope);
+    fit_solve(&state->drift, 0, &summary->drift, &summary->drift_slope);
+    summary->predicted_pre = state->last_post + summary->gain;
+    summary->suggested_goal = summary->predicted_pre - dry_weight;
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "treatment_data.h"
+
+// Fixed-point weighted least-squares trends over completed treatments,
+// updated in O(1) per treatment without re-reading history.
+//
+// Two series are fitted against treatment number (x = 0 for the latest):
+//   gain  - interdialytic weight gain: pre_weight - previous post_weight
+//   drift - achieved post_weight - prescribed dry_weight
+//
+// Older treatments are down-weighted by 1/32 per new treatment (half-life
+// of ~22 treatments, about seven weeks), so the fit follows recent changes
+// and history eviction needs no correction.
+
+#define TREND_WEIGHT_ONE     1024    // Weight of the newest sample
+#define TREND_DECAY_DIVISOR  32      // Weights shrink by 1/32 per treatment
+#define TREND_MIN_SAMPLES    3       // Before this, no trend is reported
+
+// Weighted sums for y = a + b*x
+typedef struct {
+    int64_t w;
+    int64_t wx;
+    int64_t wxx;
+    int64_t wy;
+    int64_t wxy;
+} TrendFit;
+
+// Persisted state. All fields are naturally aligned (no padding).
+typedef struct {
+    TrendFit gain;              // y in x10 kg
+    TrendFit drift;             // y in x10 kg
+    int32_t last_post;          // Previous post_weight (x10), 0 if none
+    uint16_t samples;           // Completed treatments seen
+    uint16_t reserved;
+} TrendState;
+
+typedef struct {
+    int32_t gain;               // Expected gain before the next session (x10 kg)
+    int32_t gain_slope;         // Change in gain per treatment (x100 kg)
+    int32_t drift;              // Current post - dry (x10 kg, + = above dry)
+    int32_t drift_slope;        // Change in drift per treatment (x100 kg)
+    int32_t predicted_pre;      // Last post + expected gain (x10 kg)
+    int32_t suggested_goal;     // predicted_pre - dry weight (x10 kg)
+} TrendSummary;
+
+void trend_init(TrendState *state);
+
+// Fold in a saved treatment (ignored unless complete)
+void trend_add(TrendState *state, const TreatmentRecord *record);
+
+// Solve the fits; dry_weight (x10) is the currently prescribed one.
+// Returns false until TREND_MIN_SAMPLES treatments have been seen.
+bool trend_summarize(const TrendState *state, int32_t dry_weight, TrendSummary *summary);
@@ -0,0 +1,18 @@
+#pragma once
+
+// Developer build switches. Everything defaults to off so release builds
+// carry none of the instrumentation; flip a value here (or pass -D<NAME>=1)
+// and run the app in the emulator to get results in `./pebble.sh logs`.
+
+// Test hooks (call counters, schema override) for the host suites in
+// test/host, whose Makefile sets this; never needed in the watch app
+#ifndef ENABLE_BENCHMARKS
+#define ENABLE_BENCHMARKS 0
+#endif
+
+// Record hot-path events into a RAM ring and count flash writes, redraws,
+// vibes and clicks per session (debug/trace.h). Dumped to the log with a
+// long SELECT press in the history browser, or a TraceDump AppMessage.
+#ifndef ENABLE_TRACE
+#define ENABLE_TRACE 0
+#endif
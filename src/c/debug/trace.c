@@ -0,0 +1,115 @@
+#include "trace.h"
+
+#if ENABLE_TRACE
+
+#include "../data/storage.h"
+#include "../ui/render_scheduler.h"
+
+typedef struct {
+    uint32_t ms;                // Since trace_init()
+    uint32_t arg;
+    uint16_t event;             // TraceEvent
+} TraceEntry;
+
+// Persisted counters. All fields are uint32_t (no padding).
+typedef struct {
+    uint32_t sessions;
+    uint32_t last[TRACE_COUNTER_COUNT];
+    uint32_t total[TRACE_COUNTER_COUNT];
+} TraceHistory;
+
+static const char *const s_event_names[TRACE_EVENT_COUNT] = {
+    [TRACE_CLICK] = "click",
+    [TRACE_UPDATE_DISPLAY] = "update_display",
+    [TRACE_UPDATE_CALCULATIONS] = "update_calculations",
+    [TRACE_UPDATE_RESULTS] = "update_results",
+    [TRACE_UPDATE_PROGRESS] = "update_progress",
+    [TRACE_STORAGE_EXISTS] = "exists",
+    [TRACE_STORAGE_READ] = "read",
+    [TRACE_STORAGE_WRITE] = "write",
+    [TRACE_STORAGE_DELETE] = "delete",
+    [TRACE_STORAGE_SAVE_IN_PROGRESS] = "save_in_progress",
+    [TRACE_STORAGE_SAVE_DEFERRED] = "save_deferred",
+    [TRACE_STORAGE_SAVE_UI] = "save_ui",
+    [TRACE_STORAGE_FLUSH] = "flush",
+    [TRACE_STORAGE_LOAD_IN_PROGRESS] = "load_in_progress",
+    [TRACE_STORAGE_CLEAR_IN_PROGRESS] = "clear_in_progress",
+    [TRACE_STORAGE_HISTORY_COUNT] = "history_count",
+    [TRACE_STORAGE_SAVE_HISTORY] = "save_history",
+    [TRACE_STORAGE_IMPORT_HISTORY] = "import_history",
+    [TRACE_STORAGE_UPDATE_HISTORY] = "update_history",
+    [TRACE_STORAGE_LOAD_HISTORY] = "load_history",
+    [TRACE_STORAGE_LOAD_BETWEEN] = "load_between",
+    [TRACE_STORAGE_LOAD_STATS] = "load_stats",
+    [TRACE_STORAGE_GET_TREND] = "get_trend",
+    [TRACE_STORAGE_CLEAR_HISTORY] = "clear_history",
+    [TRACE_STORAGE_MIGRATE_PAGE] = "migrate_page",
+};
+
+static TraceEntry s_ring[TRACE_RING_SIZE];
+static uint32_t s_recorded;                 // Events ever recorded
+static uint32_t s_start_ms;
+static uint32_t s_counters[TRACE_COUNTER_COUNT];
+static TraceHistory s_history;
+
+void trace_init(void) {
+    s_start_ms = render_clock_ms();
+    if (storage_load_session_counters(&s_history, sizeof(s_history)) != (int)sizeof(s_history)) {
+        memset(&s_history, 0, sizeof(s_history));
+    }
+}
+
+void trace_deinit(void) {
+    // The save below is this session's last flash write; it is counted
+    // when made, after the counters are folded, so add it here
+    uint32_t pending[TRACE_COUNTER_COUNT] = {
+        [TRACE_COUNTER_FLASH_WRITES] = 1,
+        [TRACE_COUNTER_BYTES_WRITTEN] = sizeof(s_history),
+    };
+    s_history.sessions++;
+    for (int i = 0; i < TRACE_COUNTER_COUNT; i++) {
+        s_history.last[i] = s_counters[i] + pending[i];
+        s_history.total[i] += s_counters[i] + pending[i];
+    }
+    storage_save_session_counters(&s_history, sizeof(s_history));
+}
+
+void trace_record(TraceEvent event, uint32_t arg) {
+    TraceEntry *entry = &s_ring[s_recorded % TRACE_RING_SIZE];
+    entry->ms = render_clock_ms() - s_start_ms;
+    entry->arg = arg;
+    entry->event = (uint16_t)event;
+    s_recorded++;
+}
+
+void trace_count(TraceCounter counter, uint32_t n) {
+    s_counters[counter] += n;
+}
+
+static void dump_counters(const char *name, const uint32_t *values) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "trace %s: %ld flash writes, %ld bytes, %ld redraws, %ld vibes, %ld clicks",
+            name,
+            (long)values[TRACE_COUNTER_FLASH_WRITES], (long)values[TRACE_COUNTER_BYTES_WRITTEN],
+            (long)values[TRACE_COUNTER_REDRAWS], (long)values[TRACE_COUNTER_VIBES],
+            (long)values[TRACE_COUNTER_CLICKS]);
+}
+
+void trace_dump(void) {
+    uint32_t first = (s_recorded > TRACE_RING_SIZE) ? s_recorded - TRACE_RING_SIZE : 0;
+    APP_LOG(APP_LOG_LEVEL_INFO, "trace: last %ld of %ld events",
+            (long)(s_recorded - first), (long)s_recorded);
+    for (uint32_t n = first; n < s_recorded; n++) {
+        const TraceEntry *entry = &s_ring[n % TRACE_RING_SIZE];
+        APP_LOG(APP_LOG_LEVEL_INFO, "  %6ld ms  %-20s %lu",
+                (long)entry->ms, s_event_names[entry->event], (unsigned long)entry->arg);
+    }
+
+    dump_counters("this session", s_counters);
+    if (s_history.sessions > 0) {
+        dump_counters("last session", s_history.last);
+        APP_LOG(APP_LOG_LEVEL_INFO, "trace: %ld earlier sessions", (long)s_history.sessions);
+        dump_counters("all earlier", s_history.total);
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "debug_config.h"
+
+// Hot-path tracing. TRACE() appends (event, ms since launch, arg) to a
+// fixed ring of the last TRACE_RING_SIZE events; TRACE_COUNT() adds to a
+// per-session counter. Both compile to nothing unless ENABLE_TRACE is set,
+// and their arguments are not evaluated then.
+
+#define TRACE_RING_SIZE  64
+
+typedef enum {
+    TRACE_CLICK,                    // arg: button id
+    TRACE_UPDATE_DISPLAY,           // arg: dirty bits
+    TRACE_UPDATE_CALCULATIONS,      // arg: 0
+    TRACE_UPDATE_RESULTS,           // arg: 0
+    TRACE_UPDATE_PROGRESS,          // arg: elapsed minutes
+
+    // Backend calls; arg: key
+    TRACE_STORAGE_EXISTS,
+    TRACE_STORAGE_READ,
+    TRACE_STORAGE_WRITE,
+    TRACE_STORAGE_DELETE,
+
+    // storage_* entry points; arg: 0 unless noted
+    TRACE_STORAGE_SAVE_IN_PROGRESS,
+    TRACE_STORAGE_SAVE_DEFERRED,
+    TRACE_STORAGE_SAVE_UI,
+    TRACE_STORAGE_FLUSH,
+    TRACE_STORAGE_LOAD_IN_PROGRESS,
+    TRACE_STORAGE_CLEAR_IN_PROGRESS,
+    TRACE_STORAGE_HISTORY_COUNT,
+    TRACE_STORAGE_SAVE_HISTORY,
+    TRACE_STORAGE_IMPORT_HISTORY,   // arg: records offered
+    TRACE_STORAGE_UPDATE_HISTORY,   // arg: first seq
+    TRACE_STORAGE_LOAD_HISTORY,     // arg: first index
+    TRACE_STORAGE_LOAD_BETWEEN,     // arg: from timestamp
+    TRACE_STORAGE_LOAD_STATS,
+    TRACE_STORAGE_GET_TREND,
+    TRACE_STORAGE_CLEAR_HISTORY,
+    TRACE_STORAGE_MIGRATE_PAGE,     // arg: slot
+
+    TRACE_EVENT_COUNT
+} TraceEvent;
+
+typedef enum {
+    TRACE_COUNTER_FLASH_WRITES,     // Backend writes and deletes
+    TRACE_COUNTER_BYTES_WRITTEN,
+    TRACE_COUNTER_REDRAWS,          // Layer update_proc runs
+    TRACE_COUNTER_VIBES,
+    TRACE_COUNTER_CLICKS,
+    TRACE_COUNTER_COUNT
+} TraceCounter;
+
+#if ENABLE_TRACE
+
+#define TRACE(event, arg)        trace_record((event), (uint32_t)(arg))
+#define TRACE_COUNT(counter, n)  trace_count((counter), (uint32_t)(n))
+
+// Load the counters of earlier sessions and start this one
+void trace_init(void);
+
+// Fold this session into the persisted counters
+void trace_deinit(void);
+
+void trace_record(TraceEvent event, uint32_t arg);
+void trace_count(TraceCounter counter, uint32_t n);
+
+// Log the ring (oldest first) and the counters of this session, the last
+// one and all sessions so far
+void trace_dump(void);
+
+#else
+
+#define TRACE(event, arg)        ((void)0)
+#define TRACE_COUNT(counter, n)  ((void)0)
+
+#endif
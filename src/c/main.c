@@ -6,37 +6,87 @@
 #include "data/treatment_data.h"
 #include "data/storage.h"
 #include "windows/pre_treatment_window.h"
+#include "windows/post_treatment_window.h"
+#include "windows/session_window.h"
+#include "windows/planner_window.h"
+#include "windows/history_window.h"
+#include "ui/render_scheduler.h"
+#include "ui/heap_stats.h"
+#include "comm/app_comm.h"
+#include "debug/trace.h"
 
 // Global treatment record (shared between windows)
 static TreatmentRecord s_current_treatment;
 
+// End-of-treatment alert while the app is already running
+static void wakeup_handler(WakeupId id, int32_t cookie) {
+    if (cookie == SESSION_WAKEUP_COOKIE) {
+        session_window_alert();
+    }
+}
+
 static void init(void) {
-    // Check if there's an in-progress treatment to resume
-    if (storage_has_in_progress()) {
-        if (storage_load_in_progress(&s_current_treatment)) {
-            // Successfully loaded - resume with saved data
-            APP_LOG(APP_LOG_LEVEL_INFO, "Resuming in-progress treatment");
-        } else {
-            // Failed to load - start fresh
-            init_treatment_record(&s_current_treatment);
-        }
+    render_stats_mark_launch();
+#if ENABLE_TRACE
+    trace_init();
+#endif
+
+    app_comm_init();
+
+    // Resume an in-progress treatment where it was left. This is one read;
+    // nothing is written until the user changes something.
+    UiSnapshot ui;
+    storage_reset_stats();
+    if (storage_load_in_progress(&s_current_treatment, &ui)) {
+        APP_LOG(APP_LOG_LEVEL_INFO, "Resuming in-progress treatment");
     } else {
-        // No in-progress treatment - start fresh
+        // Nothing saved (or unreadable) - start fresh
         init_treatment_record(&s_current_treatment);
+        memset(&ui, 0, sizeof(ui));
+    }
+
+    // Push the pre-treatment window, and the post or session window on top
+    // of it if that is where the user was
+    pre_treatment_window_push(&s_current_treatment, &ui);
+    if (ui.screen == UI_SCREEN_POST) {
+        post_treatment_window_push(&s_current_treatment);
+    } else if (ui.screen == UI_SCREEN_SESSION) {
+        session_window_push(&s_current_treatment);
     }
 
-    // Save as in-progress (creates new entry or updates existing)
-    storage_save_in_progress(&s_current_treatment);
+    // Launched by the end-of-treatment alert
+    wakeup_service_subscribe(wakeup_handler);
+    WakeupId wakeup_id;
+    int32_t wakeup_cookie;
+    if (launch_reason() == APP_LAUNCH_WAKEUP &&
+        wakeup_get_launch_event(&wakeup_id, &wakeup_cookie)) {
+        wakeup_handler(wakeup_id, wakeup_cookie);
+    }
 
-    // Push the pre-treatment window
-    pre_treatment_window_push(&s_current_treatment);
+    const StorageStats *io = storage_get_stats();
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "startup storage: %ld reads, %ld writes",
+            (long)io->read_calls, (long)io->write_calls);
+    heap_stats_sample("init");
 }
 
 static void deinit(void) {
-    // Save current state before exiting
-    if (!s_current_treatment.is_complete) {
-        storage_save_in_progress(&s_current_treatment);
-    }
+    // Every edit is already queued for saving; write anything still
+    // waiting on the write-behind timer before exiting
+    storage_flush_in_progress();
+
+    app_comm_deinit();
+
+#if ENABLE_TRACE
+    trace_deinit();
+#endif
+
+    // Windows are kept for the app's lifetime once created
+    heap_stats_log();
+    history_window_deinit();
+    planner_window_deinit();
+    session_window_deinit();
+    post_treatment_window_deinit();
+    pre_treatment_window_deinit();
 }
 
 int main(void) {
@@ -0,0 +1,117 @@
+#include "field_editor.h"
+#include "number_format.h"
+
+// Adapters giving every formatter the FieldFormatter signature
+static void format_time_field(char *buffer, size_t size, int32_t value) {
+    format_time(buffer, size, (int16_t)value);
+}
+
+static void format_delta_field(char *buffer, size_t size, int32_t value) {
+    format_delta(buffer, size, (int16_t)value);
+}
+
+#define WEIGHT_FIELD(member) { \
+    .offset = offsetof(TreatmentRecord, member), \
+    .is_int16 = false, \
+    .accelerates = true, \
+    .toggles = false, \
+    .min = 300,             /* 30 kg */ \
+    .max = 2000,            /* 200 kg */ \
+    .step = 1,              /* 0.1 kg */ \
+    .format = format_weight \
+}
+
+static const FieldDescriptor s_fields[EDIT_FIELD_COUNT] = {
+    [EDIT_FIELD_PRE_WEIGHT] = WEIGHT_FIELD(pre_weight),
+    [EDIT_FIELD_DRY_WEIGHT] = WEIGHT_FIELD(dry_weight),
+    [EDIT_FIELD_TIME] = {
+        .offset = offsetof(TreatmentRecord, treatment_time),
+        .is_int16 = true,
+        .accelerates = false,
+        .toggles = false,
+        .min = 60,          // 1 hr
+        .max = 480,         // 8 hr
+        .step = 15,         // 15 min increments
+        .format = format_time_field
+    },
+    [EDIT_FIELD_DELTA] = {
+        .offset = offsetof(TreatmentRecord, delta_selection),
+        .is_int16 = true,
+        .accelerates = false,
+        .toggles = true,
+        .min = 0,           // 0.2
+        .max = 1,           // 0.4
+        .step = 1,
+        .format = format_delta_field
+    },
+    [EDIT_FIELD_POST_WEIGHT] = WEIGHT_FIELD(post_weight),
+};
+
+const FieldDescriptor *field_descriptor(EditField field) {
+    return &s_fields[field];
+}
+
+int32_t field_get(EditField field, const TreatmentRecord *record) {
+    const FieldDescriptor *desc = &s_fields[field];
+    const uint8_t *ptr = (const uint8_t *)record + desc->offset;
+    return desc->is_int16 ? *(const int16_t *)ptr : *(const int32_t *)ptr;
+}
+
+static void field_set(EditField field, TreatmentRecord *record, int32_t value) {
+    const FieldDescriptor *desc = &s_fields[field];
+    uint8_t *ptr = (uint8_t *)record + desc->offset;
+    if (desc->is_int16) {
+        *(int16_t *)ptr = (int16_t)value;
+    } else {
+        *(int32_t *)ptr = value;
+    }
+}
+
+void field_format(EditField field, const TreatmentRecord *record, char *buffer, size_t size) {
+    s_fields[field].format(buffer, size, field_get(field, record));
+}
+
+static int32_t current_step(const FieldEditor *editor, const FieldDescriptor *desc) {
+    if (!desc->accelerates) {
+        return desc->step;
+    }
+    if (editor->repeats >= FIELD_ACCEL_STAGE2_REPEATS) {
+        return desc->step * FIELD_ACCEL_STAGE2_FACTOR;
+    }
+    if (editor->repeats >= FIELD_ACCEL_STAGE1_REPEATS) {
+        return desc->step * FIELD_ACCEL_STAGE1_FACTOR;
+    }
+    return desc->step;
+}
+
+bool field_editor_step(FieldEditor *editor, EditField field, TreatmentRecord *record,
+                       int direction, bool repeating) {
+    const FieldDescriptor *desc = &s_fields[field];
+    int32_t value = field_get(field, record);
+    int32_t next;
+
+    editor->repeats = repeating ? editor->repeats + 1 : 0;
+
+    if (desc->toggles) {
+        next = (value == desc->min) ? desc->max : desc->min;
+    } else {
+        int32_t step = current_step(editor, desc);
+        int32_t remainder = value % step;
+        if (remainder == 0) {
+            next = value + direction * step;
+        } else if (direction > 0) {
+            // Snap onto the coarser grid first (e.g. 75.3 -> 75.5)
+            next = value - remainder + step;
+        } else {
+            next = value - remainder;
+        }
+        if (next < desc->min) next = desc->min;
+        if (next > desc->max) next = desc->max;
+    }
+
+    if (next == value) {
+        return false;
+    }
+    field_set(field, record, next);
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "../data/treatment_data.h"
+
+// Table-driven numeric entry shared by the pre- and post-treatment windows.
+// Each editable TreatmentRecord field declares its range, base step and
+// formatter; holding a button accelerates the step.
+
+typedef enum {
+    EDIT_FIELD_PRE_WEIGHT,
+    EDIT_FIELD_DRY_WEIGHT,
+    EDIT_FIELD_TIME,
+    EDIT_FIELD_DELTA,
+    EDIT_FIELD_POST_WEIGHT,
+    EDIT_FIELD_COUNT
+} EditField;
+
+// Acceleration curve, in repeats of a held button (100 ms each):
+// base step, then x5 after STAGE1, then x10 after STAGE2.
+// For weights that is 0.1 -> 0.5 -> 1.0 kg.
+#define FIELD_ACCEL_STAGE1_REPEATS  5
+#define FIELD_ACCEL_STAGE1_FACTOR   5
+#define FIELD_ACCEL_STAGE2_REPEATS  10
+#define FIELD_ACCEL_STAGE2_FACTOR   10
+
+typedef void (*FieldFormatter)(char *buffer, size_t size, int32_t value);
+
+typedef struct {
+    uint8_t offset;             // offsetof() the value in TreatmentRecord
+    bool is_int16;              // Value is int16_t rather than int32_t
+    bool accelerates;           // Apply the acceleration curve when held
+    bool toggles;               // Two-state field: any step flips min/max
+    int32_t min;
+    int32_t max;
+    int32_t step;               // Base step in the field's own units
+    FieldFormatter format;
+} FieldDescriptor;
+
+// Hold tracking for one window
+typedef struct {
+    uint16_t repeats;           // Steps since the button went down
+} FieldEditor;
+
+const FieldDescriptor *field_descriptor(EditField field);
+
+int32_t field_get(EditField field, const TreatmentRecord *record);
+
+// Format a field's current value for display
+void field_format(EditField field, const TreatmentRecord *record, char *buffer, size_t size);
+
+// Apply one step in direction (+1/-1). repeating is true for auto-repeat
+// events of a held button. Returns true if the value changed.
+bool field_editor_step(FieldEditor *editor, EditField field, TreatmentRecord *record,
+                       int direction, bool repeating);
@@ -0,0 +1,32 @@
+#include "heap_stats.h"
+
+static HeapStats s_stats;
+
+void heap_stats_sample(const char *where) {
+    size_t used = heap_bytes_used();
+    size_t free_bytes = heap_bytes_free();
+
+    if (s_stats.samples == 0 || free_bytes < s_stats.min_free) {
+        s_stats.min_free = free_bytes;
+    }
+    if (s_stats.samples == 0 || used > s_stats.peak_used) {
+        s_stats.peak_used = used;
+        s_stats.peak_at = where;
+    }
+    s_stats.samples++;
+}
+
+const HeapStats *heap_stats_get(void) {
+    return &s_stats;
+}
+
+void heap_stats_log(void) {
+    if (s_stats.samples == 0) {
+        return;
+    }
+    APP_LOG(APP_LOG_LEVEL_INFO, "heap: peak %d bytes used (at %s), min %d free, %ld samples",
+            (int)s_stats.peak_used, s_stats.peak_at, (int)s_stats.min_free, (long)s_stats.samples);
+    if (s_stats.peak_used > HEAP_BUDGET_BYTES) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "heap: peak over the %d byte budget", HEAP_BUDGET_BYTES);
+    }
+}
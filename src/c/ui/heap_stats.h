@@ -0,0 +1,33 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+
+// Heap high-water marks, sampled at every window transition. Window data
+// lives in static slots and windows keep their layers once created, so
+// after each window has been shown once the heap should stop moving.
+
+// Peak heap use the app is expected to stay under
+#if defined(PBL_PLATFORM_APLITE)
+#define HEAP_BUDGET_BYTES   6144
+#else
+#define HEAP_BUDGET_BYTES   12288
+#endif
+
+typedef struct {
+    uint32_t samples;
+    size_t peak_used;           // Highest heap_bytes_used() seen
+    size_t min_free;            // Lowest heap_bytes_free() seen
+    const char *peak_at;        // Transition where peak_used was reached
+} HeapStats;
+
+// Record heap use at a transition; where must be a string literal
+void heap_stats_sample(const char *where);
+
+const HeapStats *heap_stats_get(void);
+
+// Log the marks; warns if the peak is over HEAP_BUDGET_BYTES
+void heap_stats_log(void);
@@ -1,55 +1,131 @@
 #include "number_format.h"
-#include <stdlib.h>
 
-// Helper to get absolute value
-static int32_t abs_val(int32_t x) {
-    return (x < 0) ? -x : x;
+// All formatters write straight into the caller's buffer without going
+// through printf. Output is always NUL-terminated and truncated to fit.
+
+#if ENABLE_BENCHMARKS
+static uint32_t s_calls;
+#define COUNT_CALL()  (s_calls++)
+
+uint32_t number_format_call_count(void) {
+    return s_calls;
+}
+#else
+#define COUNT_CALL()  ((void)0)
+#endif
+
+// Append a string; returns the new write position
+static char *put_str(char *p, char *end, const char *s) {
+    while (*s && p < end) {
+        *p++ = *s++;
+    }
+    return p;
+}
+
+static char *put_char(char *p, char *end, char c) {
+    if (p < end) {
+        *p++ = c;
+    }
+    return p;
+}
+
+// Append a fixed-point value with the given number of decimals, e.g.
+// (-5, 1) -> "-0.5", (94, 2) -> "0.94". With force_sign, non-negative
+// values get a leading '+'.
+static char *put_fixed(char *p, char *end, int32_t value, int decimals, bool force_sign) {
+    uint32_t magnitude = (value < 0) ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+
+    // Digits least significant first; always at least one whole digit
+    char digits[12];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0 || count <= decimals);
+
+    if (value < 0) {
+        p = put_char(p, end, '-');
+    } else if (force_sign) {
+        p = put_char(p, end, '+');
+    }
+    while (count > 0) {
+        if (count == decimals) {
+            p = put_char(p, end, '.');
+        }
+        p = put_char(p, end, digits[--count]);
+    }
+    return p;
+}
+
+// Append minutes as "H:MM"
+static char *put_time(char *p, char *end, int16_t minutes) {
+    if (minutes < 0) {
+        p = put_char(p, end, '-');
+        minutes = -minutes;
+    }
+    p = put_fixed(p, end, minutes / 60, 0, false);
+    p = put_char(p, end, ':');
+    p = put_char(p, end, (char)('0' + (minutes % 60) / 10));
+    return put_char(p, end, (char)('0' + minutes % 10));
 }
 
 // Format a fixed-point value (x10) as "XX.X"
 void format_weight(char *buffer, size_t size, int32_t value_x10) {
-    int32_t whole = value_x10 / 10;
-    int32_t frac = abs_val(value_x10 % 10);
-    snprintf(buffer, size, "%ld.%ld", (long)whole, (long)frac);
+    COUNT_CALL();
+    *put_fixed(buffer, buffer + size - 1, value_x10, 1, false) = '\0';
 }
 
 // Format time in minutes as "H:MM"
 void format_time(char *buffer, size_t size, int16_t minutes) {
-    int hours = minutes / 60;
-    int mins = minutes % 60;
-    snprintf(buffer, size, "%d:%02d", hours, mins);
+    COUNT_CALL();
+    *put_time(buffer, buffer + size - 1, minutes) = '\0';
 }
 
 // Format UFR (x100) as "X.XX"
 void format_ufr(char *buffer, size_t size, int32_t ufr_x100) {
-    int32_t whole = ufr_x100 / 100;
-    int32_t frac = abs_val(ufr_x100 % 100);
-    snprintf(buffer, size, "%ld.%02ld", (long)whole, (long)frac);
+    COUNT_CALL();
+    *put_fixed(buffer, buffer + size - 1, ufr_x100, 2, false) = '\0';
 }
 
-// Format percentage (x10) as "XXX.X"
+// Format percentage (x10) as "XXX.X%"
 void format_percentage(char *buffer, size_t size, int32_t percent_x10) {
-    int32_t whole = percent_x10 / 10;
-    int32_t frac = abs_val(percent_x10 % 10);
-    snprintf(buffer, size, "%ld.%ld%%", (long)whole, (long)frac);
+    COUNT_CALL();
+    char *end = buffer + size - 1;
+    char *p = put_fixed(buffer, end, percent_x10, 1, false);
+    *put_char(p, end, '%') = '\0';
 }
 
 // Format delta selection as "0.2" or "0.4"
 void format_delta(char *buffer, size_t size, int16_t delta_selection) {
-    if (delta_selection == 0) {
-        snprintf(buffer, size, "0.2");
-    } else {
-        snprintf(buffer, size, "0.4");
-    }
+    COUNT_CALL();
+    *put_str(buffer, buffer + size - 1, (delta_selection == 0) ? "0.2" : "0.4") = '\0';
 }
 
 // Format variance (x10) with +/- sign
 void format_variance(char *buffer, size_t size, int32_t variance_x10) {
-    int32_t whole = variance_x10 / 10;
-    int32_t frac = abs_val(variance_x10 % 10);
-    if (variance_x10 >= 0) {
-        snprintf(buffer, size, "+%ld.%ld", (long)whole, (long)frac);
-    } else {
-        snprintf(buffer, size, "%ld.%ld", (long)whole, (long)frac);
+    COUNT_CALL();
+    *put_fixed(buffer, buffer + size - 1, variance_x10, 1, true) = '\0';
+}
+
+// Compose "<prefix><value><suffix>" in one pass, e.g. "Goal: 3.0 kg"
+void format_fixed_label(char *buffer, size_t size, const char *prefix,
+                        int32_t value, FixedFormat format, const char *suffix) {
+    COUNT_CALL();
+    char *end = buffer + size - 1;
+    char *p = put_str(buffer, end, prefix);
+    switch (format) {
+        case FIXED_X10:
+            p = put_fixed(p, end, value, 1, false);
+            break;
+        case FIXED_X100:
+            p = put_fixed(p, end, value, 2, false);
+            break;
+        case FIXED_X10_SIGNED:
+            p = put_fixed(p, end, value, 1, true);
+            break;
+        case FIXED_MINUTES:
+            p = put_time(p, end, (int16_t)value);
+            break;
     }
+    *put_str(p, end, suffix) = '\0';
 }
@@ -5,6 +5,15 @@
 #pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
 #include <pebble.h>
 #pragma GCC diagnostic pop
+#include "../debug/debug_config.h"
+
+// Fixed-point encodings understood by format_fixed_label()
+typedef enum {
+    FIXED_X10,          // "XX.X"   (weights, percentages)
+    FIXED_X100,         // "X.XX"   (UFR)
+    FIXED_X10_SIGNED,   // "+X.X" / "-X.X" (variance)
+    FIXED_MINUTES       // "H:MM"   (treatment time)
+} FixedFormat;
 
 // Format a fixed-point value (x10) as "XX.X" for weights
 void format_weight(char *buffer, size_t size, int32_t value_x10);
@@ -15,7 +24,7 @@ void format_time(char *buffer, size_t size, int16_t minutes);
 // Format UFR (x100) as "X.XX"
 void format_ufr(char *buffer, size_t size, int32_t ufr_x100);
 
-// Format percentage (x10) as "XXX.X"
+// Format percentage (x10) as "XXX.X%"
 void format_percentage(char *buffer, size_t size, int32_t percent_x10);
 
 // Format delta selection as "0.2" or "0.4"
@@ -23,3 +32,12 @@ void format_delta(char *buffer, size_t size, int16_t delta_selection);
 
 // Format variance (x10) with +/- sign as "+X.X" or "-X.X"
 void format_variance(char *buffer, size_t size, int32_t variance_x10);
+
+// Compose "<prefix><value><suffix>" directly into buffer, e.g. "Goal: 3.0 kg"
+void format_fixed_label(char *buffer, size_t size, const char *prefix,
+                        int32_t value, FixedFormat format, const char *suffix);
+
+#if ENABLE_BENCHMARKS
+// Formatter calls so far, for per-event cost accounting
+uint32_t number_format_call_count(void);
+#endif
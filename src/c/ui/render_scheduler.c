@@ -0,0 +1,134 @@
+#include "render_scheduler.h"
+#include "../debug/trace.h"
+
+#if defined(PBL_PLATFORM_APLITE)
+#define PLATFORM_NAME "aplite"
+#elif defined(PBL_PLATFORM_BASALT)
+#define PLATFORM_NAME "basalt"
+#elif defined(PBL_PLATFORM_CHALK)
+#define PLATFORM_NAME "chalk"
+#elif defined(PBL_PLATFORM_DIORITE)
+#define PLATFORM_NAME "diorite"
+#elif defined(PBL_PLATFORM_EMERY)
+#define PLATFORM_NAME "emery"
+#else
+#define PLATFORM_NAME "unknown"
+#endif
+
+static RenderStats s_stats;
+
+// First-frame timing: start time (0 when idle) and what is being timed
+static uint32_t s_transition_ms;
+static const char *s_transition_name;
+
+static void frame_callback(void *context) {
+    RenderScheduler *scheduler = (RenderScheduler *)context;
+    scheduler->timer = NULL;
+    render_scheduler_flush(scheduler);
+}
+
+void render_scheduler_init(RenderScheduler *scheduler, RenderCallback render, void *context) {
+    scheduler->dirty = 0;
+    scheduler->timer = NULL;
+    scheduler->render = render;
+    scheduler->context = context;
+}
+
+void render_scheduler_mark(RenderScheduler *scheduler, uint32_t dirty) {
+    scheduler->dirty |= dirty;
+    if (!scheduler->timer) {
+        scheduler->timer = app_timer_register(RENDER_FRAME_MS, frame_callback, scheduler);
+    }
+}
+
+void render_scheduler_flush(RenderScheduler *scheduler) {
+    if (scheduler->timer) {
+        app_timer_cancel(scheduler->timer);
+        scheduler->timer = NULL;
+    }
+    if (!scheduler->dirty) {
+        return;
+    }
+
+    uint32_t dirty = scheduler->dirty;
+    scheduler->dirty = 0;
+    s_stats.frames++;
+    scheduler->render(scheduler->context, dirty);
+}
+
+void render_scheduler_deinit(RenderScheduler *scheduler) {
+    if (scheduler->timer) {
+        app_timer_cancel(scheduler->timer);
+        scheduler->timer = NULL;
+    }
+    scheduler->dirty = 0;
+}
+
+bool render_update_text(char *buffer, size_t size, const char *text) {
+    if (strncmp(buffer, text, size) == 0) {
+        return false;
+    }
+    strncpy(buffer, text, size - 1);
+    buffer[size - 1] = '\0';
+    s_stats.text_updates++;
+    return true;
+}
+
+void render_invalidate(Layer *layer) {
+    layer_mark_dirty(layer);
+    s_stats.invalidations++;
+}
+
+uint32_t render_clock_ms(void) {
+    time_t seconds;
+    uint16_t ms;
+    time_ms(&seconds, &ms);
+    return (uint32_t)seconds * 1000 + ms;
+}
+
+void render_stats_count_click(void) {
+    s_stats.clicks++;
+    TRACE_COUNT(TRACE_COUNTER_CLICKS, 1);
+}
+
+void render_stats_mark_launch(void) {
+    render_stats_mark_transition("launch");
+}
+
+void render_stats_mark_transition(const char *name) {
+    s_transition_ms = render_clock_ms();
+    s_transition_name = name;
+}
+
+void render_stats_record_draw(uint32_t elapsed_ms) {
+    s_stats.draws++;
+    s_stats.draw_ms += elapsed_ms;
+    TRACE_COUNT(TRACE_COUNTER_REDRAWS, 1);
+
+    if (s_transition_ms) {
+        APP_LOG(APP_LOG_LEVEL_INFO, "%s to first frame: %ld ms (%s)",
+                s_transition_name, (long)(render_clock_ms() - s_transition_ms), PLATFORM_NAME);
+        s_transition_ms = 0;
+    }
+}
+
+const RenderStats *render_stats_get(void) {
+    return &s_stats;
+}
+
+void render_stats_log_and_reset(const char *name) {
+    if (s_stats.clicks > 0) {
+        // Per-click figures as x100 fixed point
+        uint32_t text_x100 = (s_stats.text_updates * 100) / s_stats.clicks;
+        uint32_t dirty_x100 = (s_stats.invalidations * 100) / s_stats.clicks;
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "%s render: %ld clicks, %ld frames, %ld.%02ld text updates/click, %ld.%02ld invalidations/click",
+                name, (long)s_stats.clicks, (long)s_stats.frames,
+                (long)(text_x100 / 100), (long)(text_x100 % 100),
+                (long)(dirty_x100 / 100), (long)(dirty_x100 % 100));
+    }
+    if (s_stats.draws > 0) {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "%s render: %ld draws, %ld ms total",
+                name, (long)s_stats.draws, (long)s_stats.draw_ms);
+    }
+    memset(&s_stats, 0, sizeof(s_stats));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "../debug/debug_config.h"
+
+// Minimum interval between layer updates. Changes marked within one frame
+// (e.g. a burst of repeating clicks) are rendered together.
+#define RENDER_FRAME_MS  33
+
+// Called once per frame with the accumulated dirty bits
+typedef void (*RenderCallback)(void *context, uint32_t dirty);
+
+typedef struct {
+    uint32_t dirty;
+    AppTimer *timer;
+    RenderCallback render;
+    void *context;
+} RenderScheduler;
+
+// Layer update counters for measuring per-click render cost
+typedef struct {
+    uint32_t clicks;
+    uint32_t frames;
+    uint32_t text_updates;      // Value buffers whose text actually changed
+    uint32_t invalidations;     // layer_mark_dirty calls
+    uint32_t draws;             // update_proc runs
+    uint32_t draw_ms;           // Total time spent in update_procs
+} RenderStats;
+
+void render_scheduler_init(RenderScheduler *scheduler, RenderCallback render, void *context);
+
+// Mark fields dirty; the render callback runs at most once per frame
+void render_scheduler_mark(RenderScheduler *scheduler, uint32_t dirty);
+
+// Render pending changes now (e.g. on window load)
+void render_scheduler_flush(RenderScheduler *scheduler);
+
+// Cancel any pending frame without rendering
+void render_scheduler_deinit(RenderScheduler *scheduler);
+
+// Copy text into a value buffer if it differs; returns true if it changed
+bool render_update_text(char *buffer, size_t size, const char *text);
+
+// Mark a layer for redraw, counted in the render stats
+void render_invalidate(Layer *layer);
+
+// Millisecond clock for timing draws
+uint32_t render_clock_ms(void);
+
+// Instrumentation
+void render_stats_count_click(void);
+
+// Start launch-to-first-frame timing (call first thing in init()); the next
+// recorded draw logs the elapsed time and platform
+void render_stats_mark_launch(void);
+
+// Same for a click that opens a window, logged under the given name
+void render_stats_mark_transition(const char *name);
+void render_stats_record_draw(uint32_t elapsed_ms);
+const RenderStats *render_stats_get(void);
+void render_stats_log_and_reset(const char *name);
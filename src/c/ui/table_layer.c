@@ -0,0 +1,177 @@
+#include "table_layer.h"
+#include "render_scheduler.h"
+
+#define ROUND_MARGIN     4   // Extra inset from the bezel on round displays
+#define RECT_INSET       5
+#define LARGE_VALUE_LIFT 4   // 24pt values sit higher to align with labels
+
+typedef struct {
+    const TableConfig *config;
+    const void *owner;
+    GFont small_font;
+    GFont bold_font;
+    GFont large_font;
+    int8_t highlight_row;
+    TableHighlight highlight;
+    int8_t accent_row;
+    GColor accent_color;
+} TableState;
+
+static const char *row_value(const TableState *state, const TableRow *row) {
+    if (row->value_offset == TABLE_NO_VALUE) {
+        return NULL;
+    }
+    return (const char *)state->owner + row->value_offset;
+}
+
+static GFont value_font(const TableState *state, const TableRow *row) {
+    if (row->style & TABLE_ROW_LARGE) return state->large_font;
+    if (row->style & TABLE_ROW_BOLD) return state->bold_font;
+    return state->small_font;
+}
+
+#ifdef PBL_ROUND
+static int total_height(const TableConfig *config) {
+    int height = 0;
+    for (int i = 0; i < config->row_count; i++) {
+        height += config->rows[i].height;
+    }
+    return height;
+}
+
+static int isqrt(int value) {
+    int root = 0;
+    while ((root + 1) * (root + 1) <= value) {
+        root++;
+    }
+    return root;
+}
+#endif
+
+// Horizontal inset for a row; on round displays follow the bezel
+static int row_inset(GRect bounds, int y, int height) {
+#ifdef PBL_ROUND
+    int radius = bounds.size.w / 2;
+    int dy = (y + height / 2) - bounds.size.h / 2;
+    if (dy < 0) dy = -dy;
+    if (dy >= radius) {
+        return radius;
+    }
+    return radius - isqrt(radius * radius - dy * dy) + ROUND_MARGIN;
+#else
+    return RECT_INSET;
+#endif
+}
+
+static void draw_highlight(GContext *ctx, GRect box, TableHighlight highlight) {
+    if (highlight == TABLE_HIGHLIGHT_EDITING) {
+        graphics_context_set_fill_color(ctx, GColorBlack);
+        graphics_context_set_text_color(ctx, GColorWhite);
+    } else {
+        graphics_context_set_fill_color(ctx, PBL_IF_COLOR_ELSE(GColorLightGray, GColorBlack));
+        graphics_context_set_text_color(ctx, PBL_IF_COLOR_ELSE(GColorBlack, GColorWhite));
+    }
+    graphics_fill_rect(ctx, box, 0, GCornerNone);
+}
+
+static void table_update_proc(Layer *layer, GContext *ctx) {
+    uint32_t start = render_clock_ms();
+    TableState *state = layer_get_data(layer);
+    const TableConfig *config = state->config;
+    GRect bounds = layer_get_bounds(layer);
+
+    int y = PBL_IF_ROUND_ELSE((bounds.size.h - total_height(config)) / 2, config->top);
+
+    for (int i = 0; i < config->row_count; i++) {
+        const TableRow *row = &config->rows[i];
+        const char *value = row_value(state, row);
+        int inset = row_inset(bounds, y, row->height);
+        int width = bounds.size.w - 2 * inset;
+        GColor text_color = (i == state->accent_row) ? state->accent_color : GColorBlack;
+
+        if (row->style & TABLE_ROW_FULL_WIDTH) {
+            const char *text = value ? value : row->label;
+            if (text) {
+                graphics_context_set_text_color(ctx, text_color);
+                graphics_draw_text(ctx, text, value_font(state, row),
+                                   GRect(inset, y, width, row->height + 2),
+                                   GTextOverflowModeTrailingEllipsis,
+                                   (row->style & TABLE_ROW_CENTER) ? GTextAlignmentCenter : GTextAlignmentLeft,
+                                   NULL);
+            }
+            y += row->height;
+            continue;
+        }
+
+        // Label column
+        graphics_context_set_text_color(ctx, GColorBlack);
+        graphics_draw_text(ctx, row->label, state->small_font,
+                           GRect(inset, y, config->label_width, row->height),
+                           GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
+
+        // Value column, highlighted or inverted as needed
+        int lift = (row->style & TABLE_ROW_LARGE) ? LARGE_VALUE_LIFT : 0;
+        GRect box = GRect(inset + config->label_width, y - lift,
+                          width - config->label_width, row->height);
+        if (row->style & TABLE_ROW_INVERTED) {
+            draw_highlight(ctx, box, TABLE_HIGHLIGHT_EDITING);
+        } else if (i == state->highlight_row && state->highlight != TABLE_HIGHLIGHT_NONE) {
+            draw_highlight(ctx, box, state->highlight);
+        } else {
+            graphics_context_set_text_color(ctx, text_color);
+        }
+        if (value) {
+            graphics_draw_text(ctx, value, value_font(state, row), box,
+                               GTextOverflowModeTrailingEllipsis, GTextAlignmentLeft, NULL);
+        }
+        y += row->height;
+    }
+
+    render_stats_record_draw(render_clock_ms() - start);
+}
+
+TableLayer *table_layer_create(GRect frame, const TableConfig *config, const void *owner) {
+    Layer *layer = layer_create_with_data(frame, sizeof(TableState));
+    TableState *state = layer_get_data(layer);
+
+    state->config = config;
+    state->owner = owner;
+    state->small_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+    state->bold_font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+    state->large_font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
+    state->highlight_row = -1;
+    state->highlight = TABLE_HIGHLIGHT_NONE;
+    state->accent_row = -1;
+    state->accent_color = GColorBlack;
+
+    layer_set_update_proc(layer, table_update_proc);
+    return layer;
+}
+
+void table_layer_destroy(TableLayer *table) {
+    layer_destroy(table);
+}
+
+Layer *table_layer_get_layer(TableLayer *table) {
+    return table;
+}
+
+bool table_layer_set_highlight(TableLayer *table, int row, TableHighlight highlight) {
+    TableState *state = layer_get_data(table);
+    if (state->highlight_row == row && state->highlight == highlight) {
+        return false;
+    }
+    state->highlight_row = (int8_t)row;
+    state->highlight = highlight;
+    return true;
+}
+
+bool table_layer_set_accent(TableLayer *table, int row, GColor color) {
+    TableState *state = layer_get_data(table);
+    if (state->accent_row == row && gcolor_equal(state->accent_color, color)) {
+        return false;
+    }
+    state->accent_row = (int8_t)row;
+    state->accent_color = color;
+    return true;
+}
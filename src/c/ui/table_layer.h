@@ -0,0 +1,54 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+
+// A single custom-drawn Layer that renders a label/value grid from a const
+// row descriptor table, replacing one TextLayer per label and value.
+
+// Row style flags
+#define TABLE_ROW_FULL_WIDTH  0x01  // One text spanning the row (no label column)
+#define TABLE_ROW_CENTER      0x02  // Center the text (full-width rows)
+#define TABLE_ROW_BOLD        0x04  // Value in the 18pt bold font
+#define TABLE_ROW_LARGE       0x08  // Value in the 24pt bold font
+#define TABLE_ROW_INVERTED    0x10  // Value always drawn white on black
+
+// Row value not backed by a buffer (static label-only rows)
+#define TABLE_NO_VALUE        0xFFFF
+
+typedef struct {
+    const char *label;      // Static text: label column, or the whole row
+    uint16_t value_offset;  // offsetof() of the value buffer in the owner data
+    uint8_t height;         // Row pitch in pixels
+    uint8_t style;          // TABLE_ROW_* flags
+} TableRow;
+
+typedef struct {
+    const TableRow *rows;
+    uint8_t row_count;
+    uint8_t label_width;    // Width of the label column
+    uint8_t top;            // First row offset on rectangular displays
+} TableConfig;
+
+// How the highlighted row's value is drawn
+typedef enum {
+    TABLE_HIGHLIGHT_NONE,
+    TABLE_HIGHLIGHT_SELECTED,   // Light gray (black on B/W)
+    TABLE_HIGHLIGHT_EDITING     // Black
+} TableHighlight;
+
+typedef Layer TableLayer;
+
+// owner is the struct that value_offset fields index into
+TableLayer *table_layer_create(GRect frame, const TableConfig *config, const void *owner);
+void table_layer_destroy(TableLayer *table);
+Layer *table_layer_get_layer(TableLayer *table);
+
+// Set the highlighted row; returns true if anything changed
+bool table_layer_set_highlight(TableLayer *table, int row, TableHighlight highlight);
+
+// Color one row's text (e.g. variance); returns true if anything changed
+bool table_layer_set_accent(TableLayer *table, int row, GColor color);
@@ -0,0 +1,147 @@
+#include "history_window.h"
+#include "../data/storage.h"
+#include "../data/history_cache.h"
+#include "../ui/number_format.h"
+#include "../ui/render_scheduler.h"
+#include "../ui/heap_stats.h"
+#include "../debug/trace.h"
+
+typedef struct {
+    Window *window;
+    MenuLayer *menu;
+
+    // State
+    int count;                  // Records in history when last loaded
+    HistoryCache cache;
+} HistoryWindowData;
+
+// Static slot; the window and menu are created on the first push and kept
+static HistoryWindowData s_slot;
+static HistoryWindowData *s_data = NULL;   // Set while on the window stack
+static size_t s_heap_before_push;
+
+static uint16_t get_num_rows(MenuLayer *menu, uint16_t section, void *context) {
+    HistoryWindowData *data = (HistoryWindowData *)context;
+    return (data->count > 0) ? data->count : 1;
+}
+
+static void draw_row(GContext *ctx, const Layer *cell, MenuIndex *index, void *context) {
+    HistoryWindowData *data = (HistoryWindowData *)context;
+    uint32_t start = render_clock_ms();
+
+    if (data->count == 0) {
+        menu_cell_basic_draw(ctx, cell, "No history", "Saved treatments appear here", NULL);
+        return;
+    }
+
+    // Newest first
+    const HistoryCacheEntry *entry = history_cache_get(&data->cache, data->count - 1 - index->row);
+    if (!entry) {
+        menu_cell_basic_draw(ctx, cell, "Unreadable", NULL, NULL);
+        return;
+    }
+
+    char title[16];
+    time_t timestamp = entry->record.timestamp;
+    strftime(title, sizeof(title), "%a %d %b", localtime(&timestamp));
+
+    // "<removed> kg  <achieved>%"
+    char subtitle[24];
+    format_fixed_label(subtitle, sizeof(subtitle), "", entry->metrics.actual_removal, FIXED_X10, " kg  ");
+    size_t used = strlen(subtitle);
+    format_fixed_label(subtitle + used, sizeof(subtitle) - used, "",
+                       entry->metrics.percentage, FIXED_X10, "%");
+
+    menu_cell_basic_draw(ctx, cell, title, subtitle, NULL);
+    render_stats_record_draw(render_clock_ms() - start);
+}
+
+#if ENABLE_TRACE
+static void select_long_click(MenuLayer *menu, MenuIndex *index, void *context) {
+    trace_dump();
+}
+#endif
+
+static void window_load(Window *window) {
+    HistoryWindowData *data = window_get_user_data(window);
+    Layer *root = window_get_root_layer(window);
+
+    data->count = storage_get_history_count();
+    history_cache_init(&data->cache);
+
+    if (data->menu) {
+        // Shown before: pick up new treatments and start at the newest
+        menu_layer_reload_data(data->menu);
+        menu_layer_set_selected_index(data->menu, (MenuIndex) { 0, 0 }, MenuRowAlignTop, false);
+        heap_stats_sample("history load");
+        return;
+    }
+
+    data->menu = menu_layer_create(layer_get_bounds(root));
+    menu_layer_set_callbacks(data->menu, data, (MenuLayerCallbacks) {
+        .get_num_rows = get_num_rows,
+        .draw_row = draw_row,
+#if ENABLE_TRACE
+        .select_long_click = select_long_click,
+#endif
+    });
+    #ifdef PBL_COLOR
+    menu_layer_set_highlight_colors(data->menu, GColorCobaltBlue, GColorWhite);
+    #endif
+    menu_layer_set_click_config_onto_window(data->menu, window);
+    layer_add_child(root, menu_layer_get_layer(data->menu));
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "history window heap: %d bytes",
+            (int)(heap_bytes_used() - s_heap_before_push));
+    heap_stats_sample("history load");
+}
+
+static void window_unload(Window *window) {
+    HistoryWindowData *data = window_get_user_data(window);
+
+    // Per-row draw time (includes cache misses) and hit rate
+    render_stats_log_and_reset("history");
+    history_cache_log_stats(&data->cache, "history");
+
+    heap_stats_sample("history unload");
+    s_data = NULL;
+}
+
+void history_window_push(void) {
+    if (s_data != NULL) {
+        return;
+    }
+
+    s_heap_before_push = heap_bytes_used();
+    s_data = &s_slot;
+    if (!s_data->window) {
+        s_data->window = window_create();
+        window_set_user_data(s_data->window, s_data);
+        window_set_window_handlers(s_data->window, (WindowHandlers) {
+            .load = window_load,
+            .unload = window_unload
+        });
+    }
+
+    window_stack_push(s_data->window, true);
+}
+
+void history_window_refresh(void) {
+    if (s_data == NULL || !s_data->menu) {
+        return;
+    }
+    // Rows are history indexes, which an import that evicts a page shifts
+    s_data->count = storage_get_history_count();
+    history_cache_init(&s_data->cache);
+    menu_layer_reload_data(s_data->menu);
+}
+
+void history_window_deinit(void) {
+    if (s_slot.menu) {
+        menu_layer_destroy(s_slot.menu);
+    }
+    if (s_slot.window) {
+        window_destroy(s_slot.window);
+    }
+    memset(&s_slot, 0, sizeof(s_slot));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+
+// Push the history browser (newest treatment first). The window is created
+// on the first push and kept until history_window_deinit().
+void history_window_push(void);
+void history_window_deinit(void);
+
+// History changed under the window (a phone import or edit): drop the
+// cached rows and reload the menu. No-op if the window is not shown.
+void history_window_refresh(void);
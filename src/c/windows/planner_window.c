@@ -0,0 +1,158 @@
+#include "planner_window.h"
+#include "../data/storage.h"
+#include "../data/metrics_batch.h"
+#include "../ui/number_format.h"
+#include "../ui/render_scheduler.h"
+#include "../ui/heap_stats.h"
+
+typedef struct {
+    Window *window;
+    MenuLayer *menu;
+
+    // State
+    TreatmentRecord *record;
+    MetricsBatch plan;          // Every time x delta, computed once on push
+} PlannerWindowData;
+
+// Static slot; the window and menu are created on the first push and kept
+static PlannerWindowData s_slot;
+static PlannerWindowData *s_data = NULL;   // Set while on the window stack
+static size_t s_heap_before_push;
+
+static uint16_t get_num_sections(MenuLayer *menu, void *context) {
+    return METRICS_PLAN_DELTAS;
+}
+
+static uint16_t get_num_rows(MenuLayer *menu, uint16_t section, void *context) {
+    return METRICS_PLAN_DURATIONS;
+}
+
+static int16_t get_header_height(MenuLayer *menu, uint16_t section, void *context) {
+    return MENU_CELL_BASIC_HEADER_HEIGHT;
+}
+
+// "0.2: 2.8 - 3.2 kg" (optimistic - pessimistic goal)
+static void draw_header(GContext *ctx, const Layer *cell, uint16_t section, void *context) {
+    PlannerWindowData *data = (PlannerWindowData *)context;
+    int row = metrics_plan_row(section, 0);
+
+    char header[28];
+    format_delta(header, sizeof(header), section);
+    size_t used = strlen(header);
+    format_fixed_label(header + used, sizeof(header) - used, ": ",
+                       data->plan.optimistic[row], FIXED_X10, " - ");
+    used = strlen(header);
+    format_fixed_label(header + used, sizeof(header) - used, "",
+                       data->plan.pessimistic[row], FIXED_X10, " kg");
+
+    menu_cell_basic_header_draw(ctx, cell, header);
+}
+
+// "4:00  0.75 kg/h" over the UFR range for the optimistic-pessimistic goals
+static void draw_row(GContext *ctx, const Layer *cell, MenuIndex *index, void *context) {
+    PlannerWindowData *data = (PlannerWindowData *)context;
+    uint32_t start = render_clock_ms();
+    int row = metrics_plan_row(index->section, index->row);
+
+    char title[20];
+    format_time(title, sizeof(title), data->plan.minutes[row]);
+    size_t used = strlen(title);
+    format_fixed_label(title + used, sizeof(title) - used, "  ",
+                       data->plan.ufr[row], FIXED_X100, " kg/h");
+
+    char subtitle[20];
+    format_fixed_label(subtitle, sizeof(subtitle), "",
+                       data->plan.ufr_optimistic[row], FIXED_X100, " - ");
+    used = strlen(subtitle);
+    format_fixed_label(subtitle + used, sizeof(subtitle) - used, "",
+                       data->plan.ufr_pessimistic[row], FIXED_X100, "");
+
+    menu_cell_basic_draw(ctx, cell, title, subtitle, NULL);
+    render_stats_record_draw(render_clock_ms() - start);
+}
+
+// Take the highlighted time and delta back to the pre-treatment window
+static void select_click(MenuLayer *menu, MenuIndex *index, void *context) {
+    PlannerWindowData *data = (PlannerWindowData *)context;
+    render_stats_count_click();
+
+    data->record->treatment_time = data->plan.minutes[metrics_plan_row(index->section, index->row)];
+    data->record->delta_selection = index->section;
+    storage_save_in_progress_deferred(data->record);
+    window_stack_pop(true);
+}
+
+static void window_load(Window *window) {
+    PlannerWindowData *data = window_get_user_data(window);
+    Layer *root = window_get_root_layer(window);
+
+    if (data->menu) {
+        // Shown before: the plan was refilled on push
+        menu_layer_reload_data(data->menu);
+    } else {
+        data->menu = menu_layer_create(layer_get_bounds(root));
+        menu_layer_set_callbacks(data->menu, data, (MenuLayerCallbacks) {
+            .get_num_sections = get_num_sections,
+            .get_num_rows = get_num_rows,
+            .get_header_height = get_header_height,
+            .draw_header = draw_header,
+            .draw_row = draw_row,
+            .select_click = select_click
+        });
+        #ifdef PBL_COLOR
+        menu_layer_set_highlight_colors(data->menu, GColorCobaltBlue, GColorWhite);
+        #endif
+        menu_layer_set_click_config_onto_window(data->menu, window);
+        layer_add_child(root, menu_layer_get_layer(data->menu));
+    }
+
+    // Start on the record's current plan
+    int index = metrics_plan_index(data->record->treatment_time);
+    if (index >= 0) {
+        MenuIndex current = { .section = data->record->delta_selection ? 1 : 0, .row = index };
+        menu_layer_set_selected_index(data->menu, current, MenuRowAlignCenter, false);
+    }
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "planner window heap: %d bytes",
+            (int)(heap_bytes_used() - s_heap_before_push));
+    heap_stats_sample("planner load");
+}
+
+static void window_unload(Window *window) {
+    render_stats_log_and_reset("planner");
+    heap_stats_sample("planner unload");
+    s_data = NULL;
+}
+
+void planner_window_push(TreatmentRecord *record) {
+    if (s_data != NULL) {
+        return;
+    }
+
+    s_heap_before_push = heap_bytes_used();
+    s_data = &s_slot;
+    s_data->record = record;
+    if (!s_data->window) {
+        s_data->window = window_create();
+        window_set_user_data(s_data->window, s_data);
+        window_set_window_handlers(s_data->window, (WindowHandlers) {
+            .load = window_load,
+            .unload = window_unload
+        });
+    }
+
+    // The whole table is filled here; rows only format
+    metrics_batch_plan(&s_data->plan, record);
+
+    window_stack_push(s_data->window, true);
+}
+
+void planner_window_deinit(void) {
+    if (s_slot.menu) {
+        menu_layer_destroy(s_slot.menu);
+    }
+    if (s_slot.window) {
+        window_destroy(s_slot.window);
+    }
+    memset(&s_slot, 0, sizeof(s_slot));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "../data/treatment_data.h"
+
+// Push the what-if planner: UFR and goals for the record's weights at every
+// allowed treatment time, one section per delta. SELECT applies the
+// highlighted time and delta to the record and returns.
+void planner_window_push(TreatmentRecord *record);
+
+// Destroy the window kept since the first push
+void planner_window_deinit(void);
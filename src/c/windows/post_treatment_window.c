@@ -1,27 +1,29 @@
 #include "post_treatment_window.h"
 #include "../data/storage.h"
 #include "../ui/number_format.h"
+#include "../ui/render_scheduler.h"
+#include "../ui/table_layer.h"
+#include "../ui/heap_stats.h"
+#include "../ui/field_editor.h"
+#include "../comm/app_comm.h"
+#include "../debug/trace.h"
 
-typedef struct {
-    Window *window;
-
-    // Input section
-    TextLayer *title_label;
-    TextLayer *post_label;
-    TextLayer *post_value;
+// Dirty bits
+#define DIRTY_POST_WEIGHT (1u << 0)
+#define DIRTY_RESULTS     (1u << 1)
+#define DIRTY_ALL         (DIRTY_POST_WEIGHT | DIRTY_RESULTS)
 
-    // Results section
-    TextLayer *results_header;
-    TextLayer *removed_label;
-    TextLayer *goal_label;
-    TextLayer *variance_label;
-    TextLayer *percent_label;
+// Table row of the variance line (colored by sign)
+#define ROW_VARIANCE      5
 
-    // Hint
-    TextLayer *hint_label;
+typedef struct {
+    Window *window;
+    TableLayer *table;
 
-    // State
-    TreatmentRecord *record;
+    // Prewarm: the inputs the text buffers were last rendered for. Kept
+    // across pushes so a push with the same inputs skips the first render.
+    TreatmentRecord rendered;
+    bool warm;
     CalculatedMetrics metrics;
 
     // Text buffers
@@ -30,82 +32,131 @@ typedef struct {
     char goal_buf[24];
     char variance_buf[24];
     char percent_buf[24];
-} PostTreatmentWindowData;
 
-static PostTreatmentWindowData *s_data = NULL;
+    // State; everything from here on is reset on each push
+    TreatmentRecord *record;
+    FieldEditor editor;
 
-static void update_display(PostTreatmentWindowData *data);
-static void update_results(PostTreatmentWindowData *data);
+    // Rendering
+    RenderScheduler scheduler;
+} PostTreatmentWindowData;
 
-static void update_display(PostTreatmentWindowData *data) {
-    format_weight(data->post_buf, sizeof(data->post_buf), data->record->post_weight);
-    text_layer_set_text(data->post_value, data->post_buf);
+static const TableRow s_rows[] = {
+    { "POST-TREATMENT",  TABLE_NO_VALUE, 22, TABLE_ROW_FULL_WIDTH | TABLE_ROW_CENTER | TABLE_ROW_BOLD },
+    { "Post:",           offsetof(PostTreatmentWindowData, post_buf), 28, TABLE_ROW_LARGE | TABLE_ROW_INVERTED },
+    { "--- RESULTS ---", TABLE_NO_VALUE, 18, TABLE_ROW_FULL_WIDTH | TABLE_ROW_CENTER },
+    { NULL,              offsetof(PostTreatmentWindowData, removed_buf),  16, TABLE_ROW_FULL_WIDTH },
+    { NULL,              offsetof(PostTreatmentWindowData, goal_buf),     16, TABLE_ROW_FULL_WIDTH },
+    { NULL,              offsetof(PostTreatmentWindowData, variance_buf), 16, TABLE_ROW_FULL_WIDTH },
+    { NULL,              offsetof(PostTreatmentWindowData, percent_buf),  18, TABLE_ROW_FULL_WIDTH },
+    { "SELECT to save",  TABLE_NO_VALUE, 16, TABLE_ROW_FULL_WIDTH | TABLE_ROW_CENTER },
+};
+
+static const TableConfig s_table_config = {
+    .rows = s_rows,
+    .row_count = ARRAY_LENGTH(s_rows),
+    .label_width = 50,
+    .top = 2
+};
+
+// Static slot; the window and table are created on the first push and kept
+static PostTreatmentWindowData s_slot;
+static PostTreatmentWindowData *s_data = NULL;   // Set while on the window stack
+static size_t s_heap_before_push;
+
+static bool update_display(PostTreatmentWindowData *data, const TreatmentRecord *record) {
+    TRACE(TRACE_UPDATE_DISPLAY, DIRTY_POST_WEIGHT);
+    char temp[12];
+    field_format(EDIT_FIELD_POST_WEIGHT, record, temp, sizeof(temp));
+    return render_update_text(data->post_buf, sizeof(data->post_buf), temp);
 }
 
-static void update_results(PostTreatmentWindowData *data) {
-    calculate_post_metrics(data->record, &data->metrics);
+static bool update_results(PostTreatmentWindowData *data, const TreatmentRecord *record) {
+    TRACE(TRACE_UPDATE_RESULTS, 0);
+    calculate_post_metrics(record, &data->metrics);
 
-    char temp[12];
+    char line[24];
+    bool changed = false;
 
     // Removed
-    format_weight(temp, sizeof(temp), data->metrics.actual_removal);
-    snprintf(data->removed_buf, sizeof(data->removed_buf), "Removed: %s kg", temp);
-    text_layer_set_text(data->removed_label, data->removed_buf);
+    format_fixed_label(line, sizeof(line), "Removed: ", data->metrics.actual_removal, FIXED_X10, " kg");
+    changed |= render_update_text(data->removed_buf, sizeof(data->removed_buf), line);
 
     // Goal
-    format_weight(temp, sizeof(temp), data->metrics.k_goal);
-    snprintf(data->goal_buf, sizeof(data->goal_buf), "Goal:    %s kg", temp);
-    text_layer_set_text(data->goal_label, data->goal_buf);
+    format_fixed_label(line, sizeof(line), "Goal:    ", data->metrics.k_goal, FIXED_X10, " kg");
+    changed |= render_update_text(data->goal_buf, sizeof(data->goal_buf), line);
 
     // Variance (with +/- sign)
-    format_variance(temp, sizeof(temp), data->metrics.variance);
-    snprintf(data->variance_buf, sizeof(data->variance_buf), "Diff:    %s kg", temp);
-    text_layer_set_text(data->variance_label, data->variance_buf);
+    format_fixed_label(line, sizeof(line), "Diff:    ", data->metrics.variance, FIXED_X10_SIGNED, " kg");
+    changed |= render_update_text(data->variance_buf, sizeof(data->variance_buf), line);
 
     // Color the variance on color displays
     #ifdef PBL_COLOR
-    if (data->metrics.variance >= 0) {
-        text_layer_set_text_color(data->variance_label, GColorDarkGreen);
-    } else {
-        text_layer_set_text_color(data->variance_label, GColorRed);
-    }
+    changed |= table_layer_set_accent(data->table, ROW_VARIANCE,
+                                      (data->metrics.variance >= 0) ? GColorDarkGreen : GColorRed);
     #endif
 
     // Percentage
-    format_percentage(temp, sizeof(temp), data->metrics.percentage);
-    snprintf(data->percent_buf, sizeof(data->percent_buf), "Achieved: %s", temp);
-    text_layer_set_text(data->percent_label, data->percent_buf);
+    format_fixed_label(line, sizeof(line), "Achieved: ", data->metrics.percentage, FIXED_X10, "%");
+    changed |= render_update_text(data->percent_buf, sizeof(data->percent_buf), line);
+
+    return changed;
 }
 
-static void adjust_post_weight(PostTreatmentWindowData *data, int direction) {
-    data->record->post_weight += direction;
-    if (data->record->post_weight < 300) data->record->post_weight = 300;
-    if (data->record->post_weight > 2000) data->record->post_weight = 2000;
+// Frame callback from the render scheduler; redraws only if something changed
+static void render(void *context, uint32_t dirty) {
+    PostTreatmentWindowData *data = (PostTreatmentWindowData *)context;
+    bool changed = false;
 
-    update_display(data);
-    update_results(data);
-    storage_save_in_progress(data->record);
+    if (dirty & DIRTY_POST_WEIGHT) {
+        changed |= update_display(data, data->record);
+    }
+    if (dirty & DIRTY_RESULTS) {
+        changed |= update_results(data, data->record);
+    }
+    data->rendered = *data->record;
+    data->warm = true;
+    if (changed) {
+        render_invalidate(table_layer_get_layer(data->table));
+    }
 }
 
-static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
-    PostTreatmentWindowData *data = (PostTreatmentWindowData *)context;
-    adjust_post_weight(data, 1);
+static void adjust_post_weight(PostTreatmentWindowData *data, int direction, bool repeating) {
+    if (!field_editor_step(&data->editor, EDIT_FIELD_POST_WEIGHT, data->record,
+                           direction, repeating)) {
+        return;
+    }
+    render_scheduler_mark(&data->scheduler, DIRTY_ALL);
+    storage_save_in_progress_deferred(data->record);
 }
 
-static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
-    PostTreatmentWindowData *data = (PostTreatmentWindowData *)context;
-    adjust_post_weight(data, -1);
+// Button actions; the click handlers only unpack the recognizer
+static void handle_adjust(PostTreatmentWindowData *data, ButtonId button, bool repeating) {
+    render_stats_count_click();
+    TRACE(TRACE_CLICK, button);
+    adjust_post_weight(data, (button == BUTTON_ID_UP) ? 1 : -1, repeating);
 }
 
-static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
-    PostTreatmentWindowData *data = (PostTreatmentWindowData *)context;
+static void handle_select(PostTreatmentWindowData *data) {
+    render_stats_count_click();
+    TRACE(TRACE_CLICK, BUTTON_ID_SELECT);
 
-    // Mark as complete and save to history
+    // Mark as complete and save to history. If the save fails the
+    // in-progress copy is the only one, so keep it and stay here; pressing
+    // select again retries.
     data->record->is_complete = true;
-    storage_save_to_history(data->record);
+    if (!storage_save_to_history(data->record)) {
+        data->record->is_complete = false;
+        storage_flush_in_progress();
+        vibes_double_pulse();
+        TRACE_COUNT(TRACE_COUNTER_VIBES, 1);
+        return;
+    }
     storage_clear_in_progress();
+    app_comm_sync_history();
 
     vibes_long_pulse();
+    TRACE_COUNT(TRACE_COUNTER_VIBES, 1);
 
     // Pop back to pre-treatment window
     window_stack_pop(true);
@@ -114,126 +165,145 @@ static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
     init_treatment_record(data->record);
 }
 
+static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_adjust((PostTreatmentWindowData *)context, BUTTON_ID_UP,
+                  click_recognizer_is_repeating(recognizer));
+}
+
+static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_adjust((PostTreatmentWindowData *)context, BUTTON_ID_DOWN,
+                  click_recognizer_is_repeating(recognizer));
+}
+
+static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_select((PostTreatmentWindowData *)context);
+}
+
 static void click_config_provider(void *context) {
     window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, up_click_handler);
     window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, down_click_handler);
     window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
 }
 
-static TextLayer *create_text_layer(GRect frame, GFont font, GTextAlignment align) {
-    TextLayer *layer = text_layer_create(frame);
-    text_layer_set_font(layer, font);
-    text_layer_set_text_alignment(layer, align);
-    text_layer_set_background_color(layer, GColorWhite);
-    text_layer_set_text_color(layer, GColorBlack);
-    return layer;
+// Post weight starts at the dry weight
+static void default_post_weight(TreatmentRecord *record) {
+    if (record->post_weight == 0) {
+        record->post_weight = record->dry_weight;
+    }
+}
+
+// True if the buffers already show these inputs
+static bool is_rendered(const PostTreatmentWindowData *data, const TreatmentRecord *record) {
+    const TreatmentRecord *rendered = &data->rendered;
+    return data->warm &&
+           rendered->pre_weight == record->pre_weight &&
+           rendered->dry_weight == record->dry_weight &&
+           rendered->post_weight == record->post_weight &&
+           rendered->treatment_time == record->treatment_time &&
+           rendered->delta_selection == record->delta_selection;
+}
+
+static void create_table(PostTreatmentWindowData *data) {
+    Layer *root = window_get_root_layer(data->window);
+    data->table = table_layer_create(layer_get_bounds(root), &s_table_config, data);
+    layer_add_child(root, table_layer_get_layer(data->table));
 }
 
 static void window_load(Window *window) {
     PostTreatmentWindowData *data = window_get_user_data(window);
-    Layer *root = window_get_root_layer(window);
-    GRect bounds = layer_get_bounds(root);
-
-    GFont title_font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
-    GFont label_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
-    GFont value_font = fonts_get_system_font(FONT_KEY_GOTHIC_24_BOLD);
-    GFont result_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
-    GFont hint_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
-
-    int x_offset = PBL_IF_ROUND_ELSE(20, 5);
-    int width = bounds.size.w - (2 * x_offset);
-
-    int y = 2;
-
-    // Title
-    data->title_label = create_text_layer(GRect(x_offset, y, width, 20), title_font, GTextAlignmentCenter);
-    text_layer_set_text(data->title_label, "POST-TREATMENT");
-    layer_add_child(root, text_layer_get_layer(data->title_label));
-    y += 22;
-
-    // Post-weight input
-    data->post_label = create_text_layer(GRect(x_offset, y, 50, 18), label_font, GTextAlignmentLeft);
-    text_layer_set_text(data->post_label, "Post:");
-    layer_add_child(root, text_layer_get_layer(data->post_label));
-
-    data->post_value = create_text_layer(GRect(x_offset + 50, y - 4, width - 50, 28), value_font, GTextAlignmentLeft);
-    text_layer_set_background_color(data->post_value, GColorBlack);
-    text_layer_set_text_color(data->post_value, GColorWhite);
-    layer_add_child(root, text_layer_get_layer(data->post_value));
-    y += 28;
-
-    // Results header
-    data->results_header = create_text_layer(GRect(x_offset, y, width, 16), label_font, GTextAlignmentCenter);
-    text_layer_set_text(data->results_header, "--- RESULTS ---");
-    layer_add_child(root, text_layer_get_layer(data->results_header));
-    y += 18;
-
-    // Results
-    int row_height = 16;
-
-    data->removed_label = create_text_layer(GRect(x_offset, y, width, row_height), result_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->removed_label));
-    y += row_height;
-
-    data->goal_label = create_text_layer(GRect(x_offset, y, width, row_height), result_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->goal_label));
-    y += row_height;
-
-    data->variance_label = create_text_layer(GRect(x_offset, y, width, row_height), result_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->variance_label));
-    y += row_height;
-
-    data->percent_label = create_text_layer(GRect(x_offset, y, width, row_height), result_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->percent_label));
-    y += row_height + 2;
-
-    // Hint
-    data->hint_label = create_text_layer(GRect(x_offset, y, width, 16), hint_font, GTextAlignmentCenter);
-    text_layer_set_text(data->hint_label, "SELECT to save");
-    layer_add_child(root, text_layer_get_layer(data->hint_label));
-
-    // Initialize post-weight to dry weight as a starting point
-    if (data->record->post_weight == 0) {
-        data->record->post_weight = data->record->dry_weight;
+
+    if (!data->table) {
+        create_table(data);
+    }
+
+    default_post_weight(data->record);
+
+    // Nothing to render if prewarmed for these inputs
+    render_scheduler_init(&data->scheduler, render, data);
+    if (!is_rendered(data, data->record)) {
+        render_scheduler_mark(&data->scheduler, DIRTY_ALL);
+        render_scheduler_flush(&data->scheduler);
     }
 
-    update_display(data);
-    update_results(data);
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "post window heap: %d bytes",
+            (int)(heap_bytes_used() - s_heap_before_push));
+    heap_stats_sample("post load");
+}
+
+// Remember that the treatment is at the post stage
+static void window_appear(Window *window) {
+    UiSnapshot ui = *storage_get_ui_snapshot();
+    ui.screen = UI_SCREEN_POST;
+    storage_save_ui_deferred(&ui);
 }
 
 static void window_unload(Window *window) {
     PostTreatmentWindowData *data = window_get_user_data(window);
 
-    text_layer_destroy(data->title_label);
-    text_layer_destroy(data->post_label);
-    text_layer_destroy(data->post_value);
-    text_layer_destroy(data->results_header);
-    text_layer_destroy(data->removed_label);
-    text_layer_destroy(data->goal_label);
-    text_layer_destroy(data->variance_label);
-    text_layer_destroy(data->percent_label);
-    text_layer_destroy(data->hint_label);
-
-    window_destroy(window);
-    free(data);
+    storage_flush_in_progress();
+    render_scheduler_deinit(&data->scheduler);
+    render_stats_log_and_reset("post");
+
+    heap_stats_sample("post unload");
     s_data = NULL;
 }
 
+static void create_window(void) {
+    s_slot.window = window_create();
+    window_set_user_data(s_slot.window, &s_slot);
+    window_set_click_config_provider_with_context(s_slot.window, click_config_provider, &s_slot);
+    window_set_window_handlers(s_slot.window, (WindowHandlers) {
+        .load = window_load,
+        .appear = window_appear,
+        .unload = window_unload
+    });
+}
+
 void post_treatment_window_push(TreatmentRecord *record) {
     if (s_data != NULL) {
         return;
     }
 
-    s_data = calloc(1, sizeof(PostTreatmentWindowData));
+    s_heap_before_push = heap_bytes_used();
+    s_data = &s_slot;
+    memset(&s_data->record, 0, sizeof(*s_data) - offsetof(PostTreatmentWindowData, record));
     s_data->record = record;
-    s_data->window = window_create();
-
-    window_set_user_data(s_data->window, s_data);
-    window_set_click_config_provider_with_context(s_data->window, click_config_provider, s_data);
-    window_set_window_handlers(s_data->window, (WindowHandlers) {
-        .load = window_load,
-        .unload = window_unload
-    });
+    if (!s_data->window) {
+        create_window();
+    }
 
     window_stack_push(s_data->window, true);
 }
+
+void post_treatment_window_prewarm(const TreatmentRecord *record) {
+    TreatmentRecord inputs = *record;
+    default_post_weight(&inputs);
+    if (s_data != NULL || is_rendered(&s_slot, &inputs)) {
+        return;
+    }
+
+    if (!s_slot.window) {
+        create_window();
+    }
+    if (!s_slot.table) {
+        create_table(&s_slot);
+    }
+
+    // Render into the buffers now, as window_load() would
+    update_display(&s_slot, &inputs);
+    update_results(&s_slot, &inputs);
+    s_slot.rendered = inputs;
+    s_slot.warm = true;
+    heap_stats_sample("post prewarm");
+}
+
+
+void post_treatment_window_deinit(void) {
+    if (s_slot.table) {
+        table_layer_destroy(s_slot.table);
+    }
+    if (s_slot.window) {
+        window_destroy(s_slot.window);
+    }
+    memset(&s_slot, 0, sizeof(s_slot));
+}
@@ -7,5 +7,12 @@
 #pragma GCC diagnostic pop
 #include "../data/treatment_data.h"
 
-// Create and push the post-treatment window
+// Push the post-treatment window. The window is created on the first push
+// and kept until post_treatment_window_deinit().
 void post_treatment_window_push(TreatmentRecord *record);
+void post_treatment_window_deinit(void);
+
+// Create the window if needed and render the record's results into it
+// ahead of the push, so the push only has to show them. Does nothing while
+// the window is shown or already rendered for these inputs.
+void post_treatment_window_prewarm(const TreatmentRecord *record);
@@ -1,14 +1,30 @@
 #include "pre_treatment_window.h"
-#include "post_treatment_window.h"
+#include "session_window.h"
+#include "history_window.h"
+#include "planner_window.h"
 #include "../data/storage.h"
 #include "../ui/number_format.h"
-
-// Field indices
-#define FIELD_PRE_WEIGHT  0
-#define FIELD_DRY_WEIGHT  1
-#define FIELD_TIME        2
-#define FIELD_DELTA       3
-#define NUM_FIELDS        4
+#include "../ui/render_scheduler.h"
+#include "../ui/table_layer.h"
+#include "../ui/field_editor.h"
+#include "../ui/heap_stats.h"
+#include "../debug/trace.h"
+
+// Editable fields, in display order (field index == table row)
+static const EditField s_fields[] = {
+    EDIT_FIELD_PRE_WEIGHT,
+    EDIT_FIELD_DRY_WEIGHT,
+    EDIT_FIELD_TIME,
+    EDIT_FIELD_DELTA
+};
+#define NUM_FIELDS        ((int)ARRAY_LENGTH(s_fields))
+
+// Dirty bits: one per input field, plus results, trend and highlight
+#define DIRTY_FIELD(f)    (1u << (f))
+#define DIRTY_RESULTS     (1u << NUM_FIELDS)
+#define DIRTY_TREND       (1u << (NUM_FIELDS + 1))
+#define DIRTY_HIGHLIGHT   (1u << (NUM_FIELDS + 2))
+#define DIRTY_ALL         (DIRTY_HIGHLIGHT * 2 - 1)
 
 // Input mode
 typedef enum {
@@ -18,29 +34,16 @@ typedef enum {
 
 typedef struct {
     Window *window;
+    TableLayer *table;
 
-    // Input field labels
-    TextLayer *pre_label;
-    TextLayer *dry_label;
-    TextLayer *time_label;
-    TextLayer *delta_label;
-
-    // Input field values
-    TextLayer *pre_value;
-    TextLayer *dry_value;
-    TextLayer *time_value;
-    TextLayer *delta_value;
-
-    // Result labels and values
-    TextLayer *k_label;
-    TextLayer *opt_label;
-    TextLayer *pess_label;
-    TextLayer *ufr_label;
-
-    // State
+    // State; everything from here on is reset on each push
     int active_field;
     InputMode input_mode;
     TreatmentRecord *record;
+    FieldEditor editor;
+
+    // Rendering
+    RenderScheduler scheduler;
 
     // Text buffers
     char pre_buf[12];
@@ -51,295 +54,339 @@ typedef struct {
     char opt_buf[20];
     char pess_buf[20];
     char ufr_buf[20];
+    char trend_buf[24];
 } PreTreatmentWindowData;
 
-static PreTreatmentWindowData *s_data = NULL;
-
-static void update_display(PreTreatmentWindowData *data);
-static void update_calculations(PreTreatmentWindowData *data);
-static void highlight_active_field(PreTreatmentWindowData *data);
-
-// Get the value TextLayer for a field index
-static TextLayer *get_value_layer(PreTreatmentWindowData *data, int field) {
-    switch (field) {
-        case FIELD_PRE_WEIGHT: return data->pre_value;
-        case FIELD_DRY_WEIGHT: return data->dry_value;
-        case FIELD_TIME: return data->time_value;
-        case FIELD_DELTA: return data->delta_value;
-        default: return NULL;
-    }
-}
+// Row layout; input rows come first so row index == field index
+static const TableRow s_rows[] = {
+    { "Pre:",   offsetof(PreTreatmentWindowData, pre_buf),   20, TABLE_ROW_BOLD },
+    { "Dry:",   offsetof(PreTreatmentWindowData, dry_buf),   20, TABLE_ROW_BOLD },
+    { "Time:",  offsetof(PreTreatmentWindowData, time_buf),  20, TABLE_ROW_BOLD },
+    { "Delta:", offsetof(PreTreatmentWindowData, delta_buf), 20, TABLE_ROW_BOLD },
+    { NULL,     TABLE_NO_VALUE,                              4,  TABLE_ROW_FULL_WIDTH },
+    { NULL,     offsetof(PreTreatmentWindowData, k_buf),     16, TABLE_ROW_FULL_WIDTH },
+    { NULL,     offsetof(PreTreatmentWindowData, opt_buf),   16, TABLE_ROW_FULL_WIDTH },
+    { NULL,     offsetof(PreTreatmentWindowData, pess_buf),  16, TABLE_ROW_FULL_WIDTH },
+    { NULL,     offsetof(PreTreatmentWindowData, ufr_buf),   16, TABLE_ROW_FULL_WIDTH },
+    { NULL,     offsetof(PreTreatmentWindowData, trend_buf), 16, TABLE_ROW_FULL_WIDTH },
+};
+
+static const TableConfig s_table_config = {
+    .rows = s_rows,
+    .row_count = ARRAY_LENGTH(s_rows),
+    .label_width = 45,
+    .top = 2
+};
+
+// Static slot; the window and table are created on the first push and kept
+static PreTreatmentWindowData s_slot;
+static PreTreatmentWindowData *s_data = NULL;   // Set while on the window stack
+static size_t s_heap_before_push;
+
+// Update the input values flagged in dirty; returns true if any text changed
+static bool update_display(PreTreatmentWindowData *data, uint32_t dirty) {
+    TRACE(TRACE_UPDATE_DISPLAY, dirty);
+
+    // Value buffers in field order
+    char *const buffers[] = { data->pre_buf, data->dry_buf, data->time_buf, data->delta_buf };
+    const size_t sizes[] = { sizeof(data->pre_buf), sizeof(data->dry_buf),
+                             sizeof(data->time_buf), sizeof(data->delta_buf) };
+    char temp[12];
+    bool changed = false;
 
-// Highlight the active field
-static void highlight_active_field(PreTreatmentWindowData *data) {
-    // Reset all fields to normal
     for (int i = 0; i < NUM_FIELDS; i++) {
-        TextLayer *layer = get_value_layer(data, i);
-        if (layer) {
-            text_layer_set_background_color(layer, GColorWhite);
-            text_layer_set_text_color(layer, GColorBlack);
-        }
-    }
-
-    // Highlight active field
-    TextLayer *active = get_value_layer(data, data->active_field);
-    if (active) {
-        if (data->input_mode == MODE_EDITING) {
-            text_layer_set_background_color(active, GColorBlack);
-            text_layer_set_text_color(active, GColorWhite);
-        } else {
-            text_layer_set_background_color(active, PBL_IF_COLOR_ELSE(GColorLightGray, GColorBlack));
-            text_layer_set_text_color(active, PBL_IF_COLOR_ELSE(GColorBlack, GColorWhite));
+        if (dirty & DIRTY_FIELD(i)) {
+            field_format(s_fields[i], data->record, temp, sizeof(temp));
+            changed |= render_update_text(buffers[i], sizes[i], temp);
         }
     }
+    return changed;
 }
 
-// Update all display values
-static void update_display(PreTreatmentWindowData *data) {
-    format_weight(data->pre_buf, sizeof(data->pre_buf), data->record->pre_weight);
-    format_weight(data->dry_buf, sizeof(data->dry_buf), data->record->dry_weight);
-    format_time(data->time_buf, sizeof(data->time_buf), data->record->treatment_time);
-    format_delta(data->delta_buf, sizeof(data->delta_buf), data->record->delta_selection);
-
-    text_layer_set_text(data->pre_value, data->pre_buf);
-    text_layer_set_text(data->dry_value, data->dry_buf);
-    text_layer_set_text(data->time_value, data->time_buf);
-    text_layer_set_text(data->delta_value, data->delta_buf);
+// Expected pre-weight and goal from the trend engine (RAM only); the goal
+// follows the dry weight being entered
+static bool update_trend(PreTreatmentWindowData *data) {
+    TrendSummary summary;
+    char line[24];
 
-    highlight_active_field(data);
+    if (trend_summarize(storage_get_trend(), data->record->dry_weight, &summary)) {
+        format_fixed_label(line, sizeof(line), "Next: ", summary.predicted_pre, FIXED_X10, " kg, k ");
+        size_t used = strlen(line);
+        format_fixed_label(line + used, sizeof(line) - used, "", summary.suggested_goal, FIXED_X10, "");
+    } else {
+        strncpy(line, "Trend: not enough data", sizeof(line));
+    }
+    return render_update_text(data->trend_buf, sizeof(data->trend_buf), line);
 }
 
-// Update calculated results
-static void update_calculations(PreTreatmentWindowData *data) {
+// Update calculated results; returns true if any line changed
+static bool update_calculations(PreTreatmentWindowData *data) {
+    TRACE(TRACE_UPDATE_CALCULATIONS, 0);
     CalculatedMetrics metrics;
     calculate_pre_metrics(data->record, &metrics);
 
-    snprintf(data->k_buf, sizeof(data->k_buf), "Goal: ");
-    format_weight(data->k_buf + 6, sizeof(data->k_buf) - 6, metrics.k_goal);
-    strcat(data->k_buf, " kg");
+    char line[20];
+    bool changed = false;
+
+    format_fixed_label(line, sizeof(line), "Goal: ", metrics.k_goal, FIXED_X10, " kg");
+    changed |= render_update_text(data->k_buf, sizeof(data->k_buf), line);
 
-    snprintf(data->opt_buf, sizeof(data->opt_buf), "Opt:  ");
-    format_weight(data->opt_buf + 6, sizeof(data->opt_buf) - 6, metrics.optimistic);
-    strcat(data->opt_buf, " kg");
+    format_fixed_label(line, sizeof(line), "Opt:  ", metrics.optimistic, FIXED_X10, " kg");
+    changed |= render_update_text(data->opt_buf, sizeof(data->opt_buf), line);
 
-    snprintf(data->pess_buf, sizeof(data->pess_buf), "Pess: ");
-    format_weight(data->pess_buf + 6, sizeof(data->pess_buf) - 6, metrics.pessimistic);
-    strcat(data->pess_buf, " kg");
+    format_fixed_label(line, sizeof(line), "Pess: ", metrics.pessimistic, FIXED_X10, " kg");
+    changed |= render_update_text(data->pess_buf, sizeof(data->pess_buf), line);
 
-    snprintf(data->ufr_buf, sizeof(data->ufr_buf), "UFR:  ");
-    format_ufr(data->ufr_buf + 6, sizeof(data->ufr_buf) - 6, metrics.ufr);
-    strcat(data->ufr_buf, " kg/h");
+    format_fixed_label(line, sizeof(line), "UFR:  ", metrics.ufr, FIXED_X100, " kg/h");
+    changed |= render_update_text(data->ufr_buf, sizeof(data->ufr_buf), line);
+
+    return changed;
+}
+
+// Highlight the active field; returns true if the highlight moved
+static bool highlight_active_field(PreTreatmentWindowData *data) {
+    TableHighlight highlight = (data->input_mode == MODE_EDITING) ?
+        TABLE_HIGHLIGHT_EDITING : TABLE_HIGHLIGHT_SELECTED;
+    return table_layer_set_highlight(data->table, data->active_field, highlight);
+}
+
+// Frame callback from the render scheduler; redraws only if something changed
+static void render(void *context, uint32_t dirty) {
+    PreTreatmentWindowData *data = (PreTreatmentWindowData *)context;
+    bool changed = update_display(data, dirty);
 
-    text_layer_set_text(data->k_label, data->k_buf);
-    text_layer_set_text(data->opt_label, data->opt_buf);
-    text_layer_set_text(data->pess_label, data->pess_buf);
-    text_layer_set_text(data->ufr_label, data->ufr_buf);
+    if (dirty & DIRTY_RESULTS) {
+        changed |= update_calculations(data);
+    }
+    if (dirty & DIRTY_TREND) {
+        changed |= update_trend(data);
+    }
+    if (dirty & DIRTY_HIGHLIGHT) {
+        changed |= highlight_active_field(data);
+    }
+    if (changed) {
+        render_invalidate(table_layer_get_layer(data->table));
+    }
 }
 
-// Adjust value based on direction (+1 or -1)
-static void adjust_value(PreTreatmentWindowData *data, int direction) {
-    switch (data->active_field) {
-        case FIELD_PRE_WEIGHT:
-            data->record->pre_weight += direction;
-            if (data->record->pre_weight < 300) data->record->pre_weight = 300;  // 30 kg min
-            if (data->record->pre_weight > 2000) data->record->pre_weight = 2000; // 200 kg max
-            break;
-
-        case FIELD_DRY_WEIGHT:
-            data->record->dry_weight += direction;
-            if (data->record->dry_weight < 300) data->record->dry_weight = 300;
-            if (data->record->dry_weight > 2000) data->record->dry_weight = 2000;
-            break;
-
-        case FIELD_TIME:
-            data->record->treatment_time += direction * 15;  // 15 min increments
-            if (data->record->treatment_time < 60) data->record->treatment_time = 60;   // 1 hr min
-            if (data->record->treatment_time > 480) data->record->treatment_time = 480; // 8 hr max
-            break;
-
-        case FIELD_DELTA:
-            // Toggle between 0 and 1
-            data->record->delta_selection = 1 - data->record->delta_selection;
-            break;
+// Step the active field in direction (+1 or -1); held buttons accelerate
+static void adjust_value(PreTreatmentWindowData *data, int direction, bool repeating) {
+    if (!field_editor_step(&data->editor, s_fields[data->active_field], data->record,
+                           direction, repeating)) {
+        return;
     }
+    render_scheduler_mark(&data->scheduler,
+                          DIRTY_FIELD(data->active_field) | DIRTY_RESULTS | DIRTY_TREND);
+    storage_save_in_progress_deferred(data->record);
+}
 
-    update_display(data);
-    update_calculations(data);
-    storage_save_in_progress(data->record);
+// Remember the field and mode so a relaunch comes back to them
+static void save_ui_snapshot(PreTreatmentWindowData *data) {
+    UiSnapshot ui = {
+        .screen = UI_SCREEN_PRE,
+        .active_field = (uint8_t)data->active_field,
+        .editing = data->input_mode == MODE_EDITING
+    };
+    storage_save_ui_deferred(&ui);
 }
 
-// Button handlers
-static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
-    PreTreatmentWindowData *data = (PreTreatmentWindowData *)context;
+// Button actions. The click handlers below only unpack the recognizer.
+static void click_config_provider(void *context);
+
+static void handle_up(PreTreatmentWindowData *data, bool repeating) {
+    render_stats_count_click();
+    TRACE(TRACE_CLICK, BUTTON_ID_UP);
 
     if (data->input_mode == MODE_NAVIGATION) {
         data->active_field = (data->active_field - 1 + NUM_FIELDS) % NUM_FIELDS;
-        highlight_active_field(data);
+        render_scheduler_mark(&data->scheduler, DIRTY_HIGHLIGHT);
+        save_ui_snapshot(data);
     } else {
-        adjust_value(data, 1);
+        adjust_value(data, 1, repeating);
     }
 }
 
-static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
-    PreTreatmentWindowData *data = (PreTreatmentWindowData *)context;
+static void handle_down(PreTreatmentWindowData *data, bool repeating) {
+    render_stats_count_click();
+    TRACE(TRACE_CLICK, BUTTON_ID_DOWN);
 
     if (data->input_mode == MODE_NAVIGATION) {
         data->active_field = (data->active_field + 1) % NUM_FIELDS;
-        highlight_active_field(data);
+        render_scheduler_mark(&data->scheduler, DIRTY_HIGHLIGHT);
+        save_ui_snapshot(data);
     } else {
-        adjust_value(data, -1);
+        adjust_value(data, -1, repeating);
     }
 }
 
-static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
-    PreTreatmentWindowData *data = (PreTreatmentWindowData *)context;
+static void handle_select(PreTreatmentWindowData *data) {
+    render_stats_count_click();
+    TRACE(TRACE_CLICK, BUTTON_ID_SELECT);
 
     if (data->input_mode == MODE_NAVIGATION) {
         data->input_mode = MODE_EDITING;
+        save_ui_snapshot(data);
         vibes_short_pulse();
+        TRACE_COUNT(TRACE_COUNTER_VIBES, 1);
     } else {
         data->input_mode = MODE_NAVIGATION;
+        save_ui_snapshot(data);
+        storage_flush_in_progress();
     }
-    highlight_active_field(data);
+    render_scheduler_mark(&data->scheduler, DIRTY_HIGHLIGHT);
+
+    // UP/DOWN behave differently per mode
+    window_set_click_config_provider_with_context(data->window, click_config_provider, data);
 }
 
-static void select_long_handler(ClickRecognizerRef recognizer, void *context) {
-    PreTreatmentWindowData *data = (PreTreatmentWindowData *)context;
+static void handle_select_long(PreTreatmentWindowData *data) {
+    render_stats_count_click();
+    render_stats_mark_transition("pre to session");
+    TRACE(TRACE_CLICK, BUTTON_ID_SELECT);
     vibes_double_pulse();
-    post_treatment_window_push(data->record);
+    TRACE_COUNT(TRACE_COUNTER_VIBES, 1);
+    storage_flush_in_progress();
+    session_window_start(data->record);
+}
+
+static void handle_up_long(PreTreatmentWindowData *data) {
+    render_stats_count_click();
+    TRACE(TRACE_CLICK, BUTTON_ID_UP);
+    storage_flush_in_progress();
+    planner_window_push(data->record);
+}
+
+static void handle_down_long(PreTreatmentWindowData *data) {
+    render_stats_count_click();
+    TRACE(TRACE_CLICK, BUTTON_ID_DOWN);
+    storage_flush_in_progress();
+    history_window_push();
+}
+
+static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_up((PreTreatmentWindowData *)context, click_recognizer_is_repeating(recognizer));
+}
+
+static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_down((PreTreatmentWindowData *)context, click_recognizer_is_repeating(recognizer));
+}
+
+static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_select((PreTreatmentWindowData *)context);
+}
+
+static void select_long_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_select_long((PreTreatmentWindowData *)context);
+}
+
+static void up_long_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_up_long((PreTreatmentWindowData *)context);
+}
+
+static void down_long_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_down_long((PreTreatmentWindowData *)context);
 }
 
 static void click_config_provider(void *context) {
-    window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, up_click_handler);
-    window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, down_click_handler);
+    PreTreatmentWindowData *data = (PreTreatmentWindowData *)context;
+
+    if (data->input_mode == MODE_EDITING) {
+        // Held buttons repeat (and accelerate) while editing
+        window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, up_click_handler);
+        window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, down_click_handler);
+    } else {
+        // A long click cannot share a button with repeating clicks, so the
+        // planner and history shortcuts only exist while navigating
+        window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
+        window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
+        window_long_click_subscribe(BUTTON_ID_UP, 500, up_long_handler, NULL);
+        window_long_click_subscribe(BUTTON_ID_DOWN, 500, down_long_handler, NULL);
+    }
     window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
     window_long_click_subscribe(BUTTON_ID_SELECT, 500, select_long_handler, NULL);
 }
 
-// Create a text layer helper
-static TextLayer *create_text_layer(GRect frame, GFont font, GTextAlignment align) {
-    TextLayer *layer = text_layer_create(frame);
-    text_layer_set_font(layer, font);
-    text_layer_set_text_alignment(layer, align);
-    text_layer_set_background_color(layer, GColorWhite);
-    text_layer_set_text_color(layer, GColorBlack);
-    return layer;
-}
-
 static void window_load(Window *window) {
     PreTreatmentWindowData *data = window_get_user_data(window);
     Layer *root = window_get_root_layer(window);
-    GRect bounds = layer_get_bounds(root);
-
-    // Fonts
-    GFont label_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
-    GFont value_font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
-    GFont result_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
-
-    // Adjust for round displays
-    int x_offset = PBL_IF_ROUND_ELSE(20, 5);
-    int width = bounds.size.w - (2 * x_offset);
-
-    int y = 5;
-    int row_height = 20;
-    int label_width = 45;
-    int value_width = width - label_width - 5;
-
-    // Pre-weight row
-    data->pre_label = create_text_layer(GRect(x_offset, y, label_width, row_height), label_font, GTextAlignmentLeft);
-    text_layer_set_text(data->pre_label, "Pre:");
-    data->pre_value = create_text_layer(GRect(x_offset + label_width, y, value_width, row_height), value_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->pre_label));
-    layer_add_child(root, text_layer_get_layer(data->pre_value));
-    y += row_height;
-
-    // Dry weight row
-    data->dry_label = create_text_layer(GRect(x_offset, y, label_width, row_height), label_font, GTextAlignmentLeft);
-    text_layer_set_text(data->dry_label, "Dry:");
-    data->dry_value = create_text_layer(GRect(x_offset + label_width, y, value_width, row_height), value_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->dry_label));
-    layer_add_child(root, text_layer_get_layer(data->dry_value));
-    y += row_height;
-
-    // Treatment time row
-    data->time_label = create_text_layer(GRect(x_offset, y, label_width, row_height), label_font, GTextAlignmentLeft);
-    text_layer_set_text(data->time_label, "Time:");
-    data->time_value = create_text_layer(GRect(x_offset + label_width, y, value_width, row_height), value_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->time_label));
-    layer_add_child(root, text_layer_get_layer(data->time_value));
-    y += row_height;
-
-    // Delta row
-    data->delta_label = create_text_layer(GRect(x_offset, y, label_width, row_height), label_font, GTextAlignmentLeft);
-    text_layer_set_text(data->delta_label, "Delta:");
-    data->delta_value = create_text_layer(GRect(x_offset + label_width, y, value_width, row_height), value_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->delta_label));
-    layer_add_child(root, text_layer_get_layer(data->delta_value));
-    y += row_height + 5;
-
-    // Results section
-    data->k_label = create_text_layer(GRect(x_offset, y, width, row_height), result_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->k_label));
-    y += row_height - 2;
-
-    data->opt_label = create_text_layer(GRect(x_offset, y, width, row_height), result_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->opt_label));
-    y += row_height - 2;
-
-    data->pess_label = create_text_layer(GRect(x_offset, y, width, row_height), result_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->pess_label));
-    y += row_height - 2;
-
-    data->ufr_label = create_text_layer(GRect(x_offset, y, width, row_height), result_font, GTextAlignmentLeft);
-    layer_add_child(root, text_layer_get_layer(data->ufr_label));
-
-    // Initialize display
-    data->active_field = FIELD_PRE_WEIGHT;
-    data->input_mode = MODE_NAVIGATION;
-    update_display(data);
-    update_calculations(data);
+
+    if (!data->table) {
+        data->table = table_layer_create(layer_get_bounds(root), &s_table_config, data);
+        layer_add_child(root, table_layer_get_layer(data->table));
+    }
+
+    // Initialize display. The trend row needs the history log, so it is
+    // left to the next frame to keep flash reads out of the first one.
+    render_scheduler_init(&data->scheduler, render, data);
+    render_scheduler_mark(&data->scheduler, DIRTY_ALL & ~DIRTY_TREND);
+    render_scheduler_flush(&data->scheduler);
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "pre window heap: %d bytes",
+            (int)(heap_bytes_used() - s_heap_before_push));
+    heap_stats_sample("pre load");
+}
+
+// First shown, or back from another window (the planner may have changed
+// the time and delta, a saved treatment may have moved the trend)
+static void window_appear(Window *window) {
+    PreTreatmentWindowData *data = window_get_user_data(window);
+    render_scheduler_mark(&data->scheduler, DIRTY_ALL);
+    save_ui_snapshot(data);
 }
 
 static void window_unload(Window *window) {
     PreTreatmentWindowData *data = window_get_user_data(window);
 
-    text_layer_destroy(data->pre_label);
-    text_layer_destroy(data->pre_value);
-    text_layer_destroy(data->dry_label);
-    text_layer_destroy(data->dry_value);
-    text_layer_destroy(data->time_label);
-    text_layer_destroy(data->time_value);
-    text_layer_destroy(data->delta_label);
-    text_layer_destroy(data->delta_value);
-    text_layer_destroy(data->k_label);
-    text_layer_destroy(data->opt_label);
-    text_layer_destroy(data->pess_label);
-    text_layer_destroy(data->ufr_label);
-
-    window_destroy(window);
-    free(data);
+    storage_flush_in_progress();
+    render_scheduler_deinit(&data->scheduler);
+    render_stats_log_and_reset("pre");
+
+    heap_stats_sample("pre unload");
     s_data = NULL;
 }
 
-void pre_treatment_window_push(TreatmentRecord *record) {
+void pre_treatment_window_push(TreatmentRecord *record, const UiSnapshot *ui) {
     if (s_data != NULL) {
         return;  // Window already exists
     }
 
-    s_data = calloc(1, sizeof(PreTreatmentWindowData));
+    s_heap_before_push = heap_bytes_used();
+    s_data = &s_slot;
+    memset(&s_data->active_field, 0,
+           sizeof(*s_data) - offsetof(PreTreatmentWindowData, active_field));
     s_data->record = record;
-    s_data->window = window_create();
 
-    window_set_user_data(s_data->window, s_data);
+    // Set before the click config provider first runs
+    if (ui && ui->active_field < NUM_FIELDS) {
+        s_data->active_field = ui->active_field;
+        s_data->input_mode = ui->editing ? MODE_EDITING : MODE_NAVIGATION;
+    }
+
+    if (!s_data->window) {
+        s_data->window = window_create();
+        window_set_user_data(s_data->window, s_data);
+        window_set_window_handlers(s_data->window, (WindowHandlers) {
+            .load = window_load,
+            .appear = window_appear,
+            .unload = window_unload
+        });
+    }
     window_set_click_config_provider_with_context(s_data->window, click_config_provider, s_data);
-    window_set_window_handlers(s_data->window, (WindowHandlers) {
-        .load = window_load,
-        .unload = window_unload
-    });
 
     window_stack_push(s_data->window, true);
 }
 
+
+void pre_treatment_window_deinit(void) {
+    if (s_slot.table) {
+        table_layer_destroy(s_slot.table);
+    }
+    if (s_slot.window) {
+        window_destroy(s_slot.window);
+    }
+    memset(&s_slot, 0, sizeof(s_slot));
+}
+
 Window *pre_treatment_window_get_window(void) {
     return s_data ? s_data->window : NULL;
 }
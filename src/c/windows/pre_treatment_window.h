@@ -6,9 +6,13 @@
 #include <pebble.h>
 #pragma GCC diagnostic pop
 #include "../data/treatment_data.h"
+#include "../data/storage.h"
 
-// Create and push the pre-treatment window
-void pre_treatment_window_push(TreatmentRecord *record);
+// Push the pre-treatment window, restoring the field and mode from ui (NULL
+// for the first field in navigation mode). The window is created on the
+// first push and kept until pre_treatment_window_deinit().
+void pre_treatment_window_push(TreatmentRecord *record, const UiSnapshot *ui);
+void pre_treatment_window_deinit(void);
 
 // Get the window pointer (for checking if already exists)
 Window *pre_treatment_window_get_window(void);
@@ -0,0 +1,281 @@
+#include "session_window.h"
+#include "post_treatment_window.h"
+#include "../data/storage.h"
+#include "../ui/number_format.h"
+#include "../ui/render_scheduler.h"
+#include "../ui/table_layer.h"
+#include "../ui/heap_stats.h"
+#include "../debug/trace.h"
+
+// Tries at one-minute steps when another app's wakeup holds the slot
+#define WAKEUP_ATTEMPTS   3
+
+// Delay before rendering the post-treatment window in the background; after
+// the push animation, so the session's own first frame is not held up
+#define PREWARM_DELAY_MS  500
+
+typedef struct {
+    uint32_t ticks;             // Minute ticks that woke the app
+    uint32_t alerts;            // Wakeup API events
+    uint32_t redraws;           // Ticks that changed the display
+    uint32_t open_ms;           // When the view was pushed
+} SessionCounters;
+
+typedef struct {
+    Window *window;
+    TableLayer *table;
+
+    // State; everything from here on is reset on each push
+    TreatmentRecord *record;
+    SessionCounters counters;
+    AppTimer *prewarm_timer;
+
+    // Text buffers; only the time rows change while the session runs
+    char goal_buf[20];
+    char ufr_buf[20];
+    char elapsed_buf[8];
+    char remaining_buf[8];
+    char removed_buf[20];
+} SessionWindowData;
+
+static const TableRow s_rows[] = {
+    { "IN TREATMENT",      TABLE_NO_VALUE, 22, TABLE_ROW_FULL_WIDTH | TABLE_ROW_CENTER | TABLE_ROW_BOLD },
+    { "Elapsed:",          offsetof(SessionWindowData, elapsed_buf),   28, TABLE_ROW_LARGE },
+    { "Left:",             offsetof(SessionWindowData, remaining_buf), 28, TABLE_ROW_LARGE },
+    { NULL,                offsetof(SessionWindowData, removed_buf),   18, TABLE_ROW_FULL_WIDTH | TABLE_ROW_BOLD },
+    { NULL,                offsetof(SessionWindowData, goal_buf),      16, TABLE_ROW_FULL_WIDTH },
+    { NULL,                offsetof(SessionWindowData, ufr_buf),       16, TABLE_ROW_FULL_WIDTH },
+    { "SELECT when done",  TABLE_NO_VALUE, 18, TABLE_ROW_FULL_WIDTH | TABLE_ROW_CENTER },
+};
+
+static const TableConfig s_table_config = {
+    .rows = s_rows,
+    .row_count = ARRAY_LENGTH(s_rows),
+    .label_width = 60,
+    .top = 2
+};
+
+// Static slot; the window and table are created on the first push and kept
+static SessionWindowData s_slot;
+static SessionWindowData *s_data = NULL;   // Set while on the window stack
+static size_t s_heap_before_push;
+
+// Whole minutes since the start, rounded so the minute ticks (on the wall
+// clock) and the start time (at any second) agree
+static int32_t elapsed_minutes(const TreatmentRecord *record) {
+    int32_t seconds = (int32_t)(time(NULL) - record->timestamp);
+    return (seconds > 0) ? (seconds + 30) / 60 : 0;
+}
+
+// Goal and UFR do not change during the session; set once on load
+static void update_plan(SessionWindowData *data) {
+    CalculatedMetrics metrics;
+    calculate_pre_metrics(data->record, &metrics);
+    format_fixed_label(data->goal_buf, sizeof(data->goal_buf), "Goal: ", metrics.k_goal, FIXED_X10, " kg");
+    format_fixed_label(data->ufr_buf, sizeof(data->ufr_buf), "UFR:  ", metrics.ufr, FIXED_X100, " kg/h");
+}
+
+// Elapsed, remaining and the fluid that should be off by now; returns true
+// if any text changed
+static bool update_progress(SessionWindowData *data) {
+    int32_t total = data->record->treatment_time;
+    int32_t elapsed = elapsed_minutes(data->record);
+    TRACE(TRACE_UPDATE_PROGRESS, elapsed);
+    if (elapsed > total) {
+        elapsed = total;
+    }
+
+    int32_t k = data->record->pre_weight - data->record->dry_weight;
+    int32_t removed = (total > 0) ? (k * elapsed) / total : 0;
+
+    char text[20];
+    bool changed = false;
+
+    format_time(text, sizeof(text), (int16_t)elapsed);
+    changed |= render_update_text(data->elapsed_buf, sizeof(data->elapsed_buf), text);
+
+    format_time(text, sizeof(text), (int16_t)(total - elapsed));
+    changed |= render_update_text(data->remaining_buf, sizeof(data->remaining_buf), text);
+
+    format_fixed_label(text, sizeof(text), "So far: ", removed, FIXED_X10, " kg");
+    changed |= render_update_text(data->removed_buf, sizeof(data->removed_buf), text);
+
+    return changed;
+}
+
+static void log_counters(const SessionCounters *counters) {
+    uint32_t minutes = (render_clock_ms() - counters->open_ms) / 60000;
+    uint32_t hours_x10 = (minutes * 10) / 60;
+    if (hours_x10 == 0) {
+        hours_x10 = 1;  // Under six minutes: report per 0.1 h
+    }
+    APP_LOG(APP_LOG_LEVEL_INFO, "session: %ld min open, %ld ticks (%ld/h), %ld redraws (%ld/h), %ld wakeups",
+            (long)minutes, (long)counters->ticks, (long)(counters->ticks * 10 / hours_x10),
+            (long)counters->redraws, (long)(counters->redraws * 10 / hours_x10),
+            (long)counters->alerts);
+}
+
+// Once a minute; the only time the app runs while the view is open
+static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
+    SessionWindowData *data = s_data;
+    data->counters.ticks++;
+
+    if (update_progress(data)) {
+        data->counters.redraws++;
+        render_invalidate(table_layer_get_layer(data->table));
+    }
+    if (data->counters.ticks % 60 == 0) {
+        log_counters(&data->counters);
+    }
+}
+
+// Schedule the end-of-treatment alert. A wakeup within a minute of another
+// (any app's) is refused, so later minutes are tried.
+static void schedule_end_alert(const TreatmentRecord *record) {
+    wakeup_cancel_all();
+    time_t end = record->timestamp + (time_t)record->treatment_time * 60;
+
+    for (int attempt = 0; attempt < WAKEUP_ATTEMPTS; attempt++) {
+        WakeupId id = wakeup_schedule(end + attempt * 60, SESSION_WAKEUP_COOKIE, true);
+        if (id >= 0) {
+            return;
+        }
+        if (id != E_RANGE) {
+            break;
+        }
+    }
+    APP_LOG(APP_LOG_LEVEL_WARNING, "session: end alert not scheduled");
+}
+
+// The record is fixed for the whole session, so the post-treatment window
+// can be rendered now and only has to be shown on SELECT
+static void prewarm_callback(void *context) {
+    SessionWindowData *data = (SessionWindowData *)context;
+    data->prewarm_timer = NULL;
+    post_treatment_window_prewarm(data->record);
+}
+
+static void handle_select(SessionWindowData *data) {
+    render_stats_count_click();
+    render_stats_mark_transition("session to post");
+    TRACE(TRACE_CLICK, BUTTON_ID_SELECT);
+
+    // Done: the alert is no longer needed, and BACK from the post window
+    // returns to the pre-treatment window
+    wakeup_cancel_all();
+    Window *window = data->window;
+    post_treatment_window_push(data->record);
+    window_stack_remove(window, false);
+}
+
+static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
+    handle_select((SessionWindowData *)context);
+}
+
+// Leave the app with the session running; the wakeup brings it back
+static void back_click_handler(ClickRecognizerRef recognizer, void *context) {
+    render_stats_count_click();
+    window_stack_pop_all(true);
+}
+
+static void click_config_provider(void *context) {
+    window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
+    window_single_click_subscribe(BUTTON_ID_BACK, back_click_handler);
+}
+
+static void window_load(Window *window) {
+    SessionWindowData *data = window_get_user_data(window);
+    Layer *root = window_get_root_layer(window);
+
+    if (!data->table) {
+        data->table = table_layer_create(layer_get_bounds(root), &s_table_config, data);
+        layer_add_child(root, table_layer_get_layer(data->table));
+    }
+
+    update_plan(data);
+    update_progress(data);
+
+    data->counters.open_ms = render_clock_ms();
+    tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
+    data->prewarm_timer = app_timer_register(PREWARM_DELAY_MS, prewarm_callback, data);
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "session window heap: %d bytes",
+            (int)(heap_bytes_used() - s_heap_before_push));
+    heap_stats_sample("session load");
+}
+
+// Remember that a session is running, so a relaunch comes back here
+static void window_appear(Window *window) {
+    UiSnapshot ui = *storage_get_ui_snapshot();
+    ui.screen = UI_SCREEN_SESSION;
+    storage_save_ui_deferred(&ui);
+}
+
+static void window_unload(Window *window) {
+    SessionWindowData *data = window_get_user_data(window);
+
+    tick_timer_service_unsubscribe();
+    if (data->prewarm_timer) {
+        app_timer_cancel(data->prewarm_timer);
+        data->prewarm_timer = NULL;
+    }
+    log_counters(&data->counters);
+    storage_flush_in_progress();
+    render_stats_log_and_reset("session");
+
+    heap_stats_sample("session unload");
+    s_data = NULL;
+}
+
+void session_window_push(TreatmentRecord *record) {
+    if (s_data != NULL) {
+        return;
+    }
+
+    s_heap_before_push = heap_bytes_used();
+    s_data = &s_slot;
+    memset(&s_data->record, 0, sizeof(*s_data) - offsetof(SessionWindowData, record));
+    s_data->record = record;
+    if (!s_data->window) {
+        s_data->window = window_create();
+        window_set_user_data(s_data->window, s_data);
+        window_set_click_config_provider_with_context(s_data->window, click_config_provider, s_data);
+        window_set_window_handlers(s_data->window, (WindowHandlers) {
+            .load = window_load,
+            .appear = window_appear,
+            .unload = window_unload
+        });
+    }
+
+    window_stack_push(s_data->window, true);
+}
+
+
+void session_window_deinit(void) {
+    if (s_slot.table) {
+        table_layer_destroy(s_slot.table);
+    }
+    if (s_slot.window) {
+        window_destroy(s_slot.window);
+    }
+    memset(&s_slot, 0, sizeof(s_slot));
+}
+
+void session_window_start(TreatmentRecord *record) {
+    record->timestamp = time(NULL);
+    storage_save_in_progress(record);
+    schedule_end_alert(record);
+    session_window_push(record);
+}
+
+void session_window_alert(void) {
+    if (s_data) {
+        s_data->counters.alerts++;
+        if (update_progress(s_data)) {
+            s_data->counters.redraws++;
+            render_invalidate(table_layer_get_layer(s_data->table));
+        }
+    }
+    vibes_long_pulse();
+    TRACE_COUNT(TRACE_COUNTER_VIBES, 1);
+}
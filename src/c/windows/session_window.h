@@ -0,0 +1,24 @@
+#pragma once
+
+// Suppress GCC 12+ warning about strftime return type mismatch in SDK headers
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wbuiltin-declaration-mismatch"
+#include <pebble.h>
+#pragma GCC diagnostic pop
+#include "../data/treatment_data.h"
+
+// Wakeup cookie of the end-of-treatment alert
+#define SESSION_WAKEUP_COOKIE  1
+
+// Start the treatment now: stamps record->timestamp, schedules the
+// end-of-treatment wakeup and pushes the running-session view
+void session_window_start(TreatmentRecord *record);
+
+// Push the view for a session already running (e.g. after a relaunch)
+void session_window_push(TreatmentRecord *record);
+
+// Destroy the window kept since the first push
+void session_window_deinit(void);
+
+// The end-of-treatment wakeup fired, while running or as the launch reason
+void session_window_alert(void);
@@ -0,0 +1,293 @@
+// Phone-side companion: keeps a copy of the treatment history in
+// localStorage and syncs it with the watch incrementally. Every record
+// carries the watch's sequence number; the phone asks only for records
+// from its watermark on, and sends back edits and records the watch lost.
+
+var RECORD_SIZE = 12;
+var RECORD_VERSION = 1;
+var TIME_STEP_MINUTES = 15;
+var IMPORT_BATCH = 16;              // APP_COMM_IMPORT_MAX on the watch
+var MAX_SEND_ATTEMPTS = 3;
+
+var STORAGE_KEY = 'history';        // Records, oldest first
+var WATERMARK_KEY = 'watermark';    // Sequence number the phone needs next
+var EDITS_KEY = 'edits';            // Edits not yet sent: { seq: record }
+
+var pending = null;
+var outbox = [];
+var sending = false;
+
+function readU16(bytes, offset) {
+  return bytes[offset] | (bytes[offset + 1] << 8);
+}
+
+function readU32(bytes, offset) {
+  return (bytes[offset] | (bytes[offset + 1] << 8) |
+          (bytes[offset + 2] << 16)) + bytes[offset + 3] * 0x1000000;
+}
+
+function writeU16(bytes, value) {
+  bytes.push(value & 0xFF, (value >> 8) & 0xFF);
+}
+
+function writeU32(bytes, value) {
+  bytes.push(value & 0xFF, (value >>> 8) & 0xFF, (value >>> 16) & 0xFF, (value >>> 24) & 0xFF);
+}
+
+// Mirror of record_decode() in src/c/data/record_codec.c
+function decodeRecord(bytes, offset) {
+  if (bytes[offset] !== RECORD_VERSION) {
+    return null;
+  }
+  var flags = bytes[offset + 7];
+  return {
+    preWeight: readU16(bytes, offset + 1) / 10,
+    dryWeight: readU16(bytes, offset + 3) / 10,
+    postWeight: readU16(bytes, offset + 5) / 10,
+    treatmentTime: (flags & 0x3F) * TIME_STEP_MINUTES,
+    delta: (flags >> 6) & 1,
+    complete: ((flags >> 7) & 1) === 1,
+    timestamp: readU32(bytes, offset + 8)
+  };
+}
+
+// Mirror of record_encode(), appending to bytes
+function encodeRecord(record, bytes) {
+  bytes.push(RECORD_VERSION);
+  writeU16(bytes, Math.round(record.preWeight * 10));
+  writeU16(bytes, Math.round(record.dryWeight * 10));
+  writeU16(bytes, Math.round(record.postWeight * 10));
+  bytes.push((Math.round(record.treatmentTime / TIME_STEP_MINUTES) & 0x3F) |
+             (record.delta ? 0x40 : 0) | (record.complete ? 0x80 : 0));
+  writeU32(bytes, record.timestamp);
+}
+
+function load(key, fallback) {
+  var value = localStorage.getItem(key);
+  return value ? JSON.parse(value) : fallback;
+}
+
+function save(key, value) {
+  localStorage.setItem(key, JSON.stringify(value));
+}
+
+// ---------------------------------------------------------------------------
+// Outgoing messages, one in flight at a time
+// ---------------------------------------------------------------------------
+
+function sendNext() {
+  if (sending || outbox.length === 0) {
+    return;
+  }
+  sending = true;
+  var message = outbox[0];
+  Pebble.sendAppMessage(message.dict, function() {
+    outbox.shift();
+    sending = false;
+    sendNext();
+  }, function() {
+    sending = false;
+    if (++message.attempts >= MAX_SEND_ATTEMPTS) {
+      console.log('Message dropped after ' + message.attempts + ' attempts');
+      outbox.shift();
+    }
+    sendNext();
+  });
+}
+
+function queue(dict) {
+  outbox.push({ dict: dict, attempts: 0 });
+  sendNext();
+}
+
+// Ask for every record from the watermark on, and the anchor before it
+function requestSync() {
+  var watermark = load(WATERMARK_KEY, 0);
+  queue({ 'ExportRequest': 1, 'SyncSince': (watermark > 0) ? watermark - 1 : 0 });
+}
+
+// Send records in batches of IMPORT_BATCH. With firstSeq they replace the
+// watch's records from that sequence number on; otherwise they are
+// appended (the watch keeps only those newer than its newest). With
+// thenSync the last batch also asks for the whole log back.
+function sendRecords(records, firstSeq, thenSync) {
+  for (var i = 0; i < records.length; i += IMPORT_BATCH) {
+    var bytes = [];
+    var batch = records.slice(i, i + IMPORT_BATCH);
+    batch.forEach(function(record) { encodeRecord(record, bytes); });
+
+    var dict = { 'ImportRecords': bytes };
+    if (firstSeq !== undefined) {
+      dict.ImportFirstSeq = firstSeq + i;
+    }
+    if (thenSync && i + IMPORT_BATCH >= records.length) {
+      dict.ExportRequest = 1;
+      dict.SyncSince = 0;
+    }
+    queue(dict);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Watch to phone
+// ---------------------------------------------------------------------------
+
+// Add records received from the watch. A record replaces the one with the
+// same sequence number or, after the watch was reset, the one with the
+// same timestamp. Records with edits still to send are kept as edited.
+function mergeRecords(received) {
+  var history = load(STORAGE_KEY, []);
+  var edits = load(EDITS_KEY, {});
+  var bySeq = {};
+  var byTimestamp = {};
+  history.forEach(function(record, i) {
+    if (record.seq !== null) {
+      bySeq[record.seq] = i;
+    }
+    byTimestamp[record.timestamp] = i;
+  });
+
+  received.forEach(function(record) {
+    if (edits[record.seq]) {
+      return;
+    }
+    var i = bySeq[record.seq];
+    if (i === undefined) {
+      i = byTimestamp[record.timestamp];
+    }
+    if (i === undefined) {
+      history.push(record);
+    } else {
+      history[i] = record;
+    }
+  });
+
+  history.sort(function(a, b) { return a.timestamp - b.timestamp; });
+  save(STORAGE_KEY, history);
+}
+
+// The watch numbers records from 0 again after its history was cleared.
+// Offer it every record the phone holds; its records are then fetched
+// again from 0, and ours are matched to them by timestamp. Records the
+// watch could not take stay on the phone without a sequence number.
+function restoreWatch() {
+  var history = load(STORAGE_KEY, []);
+  history.forEach(function(record) { record.seq = null; });
+  save(STORAGE_KEY, history);
+  save(WATERMARK_KEY, 0);
+  console.log('Watch history was reset; restoring ' + history.length + ' records');
+
+  if (history.length === 0) {
+    requestSync();
+  } else {
+    sendRecords(history, undefined, true);
+  }
+}
+
+// Send queued edits, one message per run of consecutive sequence numbers
+function flushEdits() {
+  var edits = load(EDITS_KEY, {});
+  var seqs = Object.keys(edits).map(Number).sort(function(a, b) { return a - b; });
+  var run = [];
+  seqs.forEach(function(seq, i) {
+    run.push(edits[seq]);
+    if (i === seqs.length - 1 || seqs[i + 1] !== seq + 1) {
+      sendRecords(run, seq - run.length + 1, false);
+      run = [];
+    }
+  });
+  save(EDITS_KEY, {});
+}
+
+// The phone asks again for the last record it has (the anchor) to check
+// the watch still holds the same log. A watch whose history was cleared
+// numbers records from 0 again, and sends either records below the anchor
+// or a different record under its sequence number.
+function sameLog(sync, anchor) {
+  if (sync.firstSeq !== anchor) {
+    // Anchor evicted since (long gap): nothing to compare
+    return sync.firstSeq > anchor;
+  }
+  var theirs = sync.records[0];
+  var mine = load(STORAGE_KEY, []).filter(function(r) { return r.seq === anchor; })[0];
+  if (!theirs || theirs.seq !== anchor) {
+    return false;
+  }
+  return !mine || mine.timestamp === theirs.timestamp;
+}
+
+function handleChunk(payload) {
+  var seq = payload.ExportSeq;
+  if (!pending || seq === 0) {
+    // First chunk, of a sync we asked for or one started by the watch
+    pending = {
+      nextSeq: 0,
+      firstSeq: payload.ExportFirstSeq,
+      endSeq: payload.ExportFirstSeq + payload.ExportTotal,
+      records: []
+    };
+  }
+
+  if (seq !== pending.nextSeq) {
+    // A retried chunk we already have, or a gap: restart cleanly
+    if (seq < pending.nextSeq) {
+      return;
+    }
+    console.log('Sync chunk ' + seq + ' out of order, expected ' + pending.nextSeq);
+    pending = null;
+    return;
+  }
+  pending.nextSeq++;
+
+  var bytes = payload.ExportRecords || [];
+  var recordSeq = payload.ExportFirstSeq;
+  for (var offset = 0; offset + RECORD_SIZE <= bytes.length; offset += RECORD_SIZE) {
+    var record = decodeRecord(bytes, offset);
+    if (record) {
+      record.seq = recordSeq;
+      pending.records.push(record);
+    }
+    recordSeq++;
+  }
+
+  if (recordSeq >= pending.endSeq) {
+    var sync = pending;
+    pending = null;
+    var watermark = load(WATERMARK_KEY, 0);
+    if (watermark > 0 && !sameLog(sync, watermark - 1)) {
+      restoreWatch();
+      return;
+    }
+    mergeRecords(sync.records);
+    save(WATERMARK_KEY, sync.endSeq);
+    console.log('Sync complete: ' + sync.records.length + ' records, watermark ' + sync.endSeq);
+    flushEdits();
+  }
+}
+
+// Correct a stored treatment (e.g. from a settings page). Applied to the
+// local copy now and sent to the watch after the next sync.
+function editRecord(seq, changes) {
+  var history = load(STORAGE_KEY, []);
+  var record = history.filter(function(r) { return r.seq === seq; })[0];
+  if (!record) {
+    return false;
+  }
+  Object.keys(changes).forEach(function(field) { record[field] = changes[field]; });
+  save(STORAGE_KEY, history);
+
+  var edits = load(EDITS_KEY, {});
+  edits[seq] = record;
+  save(EDITS_KEY, edits);
+  return true;
+}
+
+Pebble.addEventListener('ready', function() {
+  requestSync();
+});
+
+Pebble.addEventListener('appmessage', function(e) {
+  if (e.payload.ExportSeq !== undefined) {
+    handleChunk(e.payload);
+  }
+});
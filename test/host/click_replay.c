@@ -0,0 +1,271 @@
+#include "click_replay.h"
+#include "stub.h"
+#include "data/storage.h"
+#include "ui/number_format.h"
+#include "ui/render_scheduler.h"
+#include "windows/pre_treatment_window.h"
+#include "windows/session_window.h"
+#include "windows/post_treatment_window.h"
+#include "windows/planner_window.h"
+#include "windows/history_window.h"
+
+// Each trace is replayed this many times; times are averaged, counts are
+// the same every round
+#define REPLAY_ROUNDS       10
+#define REPLAY_MAX_STEPS    24
+
+// Cost row of opening the pre-treatment window, ahead of the trace steps
+#define OPEN_ROW            REPLAY_MAX_STEPS
+
+// Simulated time after each event: the interval the windows repeat held
+// buttons at, else one frame so the frame the event scheduled is drawn.
+// An idle step lets a second pass (the session window prewarms the post
+// window after 500 ms).
+#define REPLAY_REPEAT_MS    100
+#define REPLAY_IDLE_MS      1000
+
+// How a replayed button went down
+typedef enum {
+    REPLAY_PRESS_SINGLE,        // Click
+    REPLAY_PRESS_REPEAT,        // Auto-repeat of a held button
+    REPLAY_PRESS_LONG,          // Long press
+    REPLAY_PRESS_FRAME          // No button: idle, timers due fire
+} ReplayPress;
+
+// Window a step is meant for; the press goes to whichever is on top
+typedef enum {
+    TARGET_PRE,
+    TARGET_SESSION,
+    TARGET_POST
+} ReplayTarget;
+
+// One line of a trace: a button pressed count times (a held button is a
+// single click followed by repeats)
+typedef struct {
+    uint8_t target;             // ReplayTarget
+    uint8_t button;             // ButtonId
+    uint8_t press;              // ReplayPress
+    uint8_t count;
+} ReplayStep;
+
+typedef struct {
+    const char *name;
+    const ReplayStep *steps;
+    uint8_t step_count;
+} ReplayTrace;
+
+#define PRE(button, press, count)      { TARGET_PRE, BUTTON_ID_##button, REPLAY_PRESS_##press, count }
+#define SESSION(button, press, count)  { TARGET_SESSION, BUTTON_ID_##button, REPLAY_PRESS_##press, count }
+#define POST(button, press, count)     { TARGET_POST, BUTTON_ID_##button, REPLAY_PRESS_##press, count }
+
+// Enter a whole treatment from the defaults: pre weight up 2.5 kg, dry
+// weight down 0.3 kg, one more hour, delta 0.4, start, finish, post weight
+// down by holding DOWN, save
+static const ReplayStep s_full_entry[] = {
+    PRE(SELECT, SINGLE, 1),
+    PRE(UP, SINGLE, 1),
+    PRE(UP, REPEAT, 8),
+    PRE(SELECT, SINGLE, 1),
+    PRE(DOWN, SINGLE, 1),
+    PRE(SELECT, SINGLE, 1),
+    PRE(DOWN, SINGLE, 3),
+    PRE(SELECT, SINGLE, 1),
+    PRE(DOWN, SINGLE, 1),
+    PRE(SELECT, SINGLE, 1),
+    PRE(UP, SINGLE, 4),
+    PRE(SELECT, SINGLE, 1),
+    PRE(DOWN, SINGLE, 1),
+    PRE(SELECT, SINGLE, 1),
+    PRE(UP, SINGLE, 1),
+    PRE(SELECT, SINGLE, 1),
+    PRE(SELECT, LONG, 1),
+    SESSION(SELECT, SINGLE, 1),
+    POST(DOWN, SINGLE, 1),
+    POST(DOWN, REPEAT, 12),
+    POST(SELECT, SINGLE, 1),
+};
+
+// Start and finish a treatment straight away, then one with 0.1 kg more
+// once the post-treatment window has been prewarmed. Each finish has inputs
+// the post window was not last rendered for.
+static const ReplayStep s_finish[] = {
+    PRE(SELECT, LONG, 1),
+    SESSION(SELECT, SINGLE, 1),
+    POST(SELECT, SINGLE, 1),
+    PRE(SELECT, SINGLE, 1),
+    PRE(UP, SINGLE, 1),
+    PRE(SELECT, SINGLE, 1),
+    PRE(SELECT, LONG, 1),
+    SESSION(SELECT, FRAME, 1),
+    SESSION(SELECT, SINGLE, 1),
+    POST(SELECT, SINGLE, 1),
+};
+
+// Hold UP on the pre weight until it has gone up 10 kg (0.1 x5, 0.5 x5,
+// then 1.0 x7 with the acceleration curve)
+static const ReplayStep s_ten_kg[] = {
+    PRE(SELECT, SINGLE, 1),
+    PRE(UP, SINGLE, 1),
+    PRE(UP, REPEAT, 16),
+    PRE(SELECT, SINGLE, 1),
+};
+
+// Walk the fields twice in each direction
+static const ReplayStep s_navigation[] = {
+    PRE(DOWN, SINGLE, 8),
+    PRE(UP, SINGLE, 8),
+};
+
+static const ReplayTrace s_corpus[] = {
+    { "full entry", s_full_entry, ARRAY_LENGTH(s_full_entry) },
+    { "finish",     s_finish,     ARRAY_LENGTH(s_finish) },
+    { "10 kg",      s_ten_kg,     ARRAY_LENGTH(s_ten_kg) },
+    { "navigation", s_navigation, ARRAY_LENGTH(s_navigation) },
+};
+
+static const char *const s_target_names[] = { "pre", "session", "post" };
+static const char *const s_button_names[] = { "BACK", "UP", "SELECT", "DOWN" };
+static const char *const s_press_names[] = { "", " held", " long", " frame" };
+
+// Cost of one step, summed over all rounds
+typedef struct {
+    uint32_t ms;
+    uint32_t formats;
+    uint32_t texts;
+    uint32_t writes;
+} StepCost;
+
+static StepCost s_costs[REPLAY_MAX_STEPS + 1];
+static TreatmentRecord s_record;
+static uint32_t s_simulated_ms;     // Clock advanced by the replay, not spent
+
+// Advance the simulated clock, running the timers that fall due
+static void advance(uint32_t ms) {
+    stub_run_timers(ms);
+    s_simulated_ms += ms;
+}
+
+// Press the button through the top window's subscriptions, then let the
+// time until the next event pass
+static bool dispatch(const ReplayStep *step) {
+    switch (step->press) {
+        case REPLAY_PRESS_FRAME:
+            advance(REPLAY_IDLE_MS);
+            return true;
+        case REPLAY_PRESS_REPEAT:
+            if (!stub_press(step->button, STUB_PRESS_REPEAT)) {
+                return false;
+            }
+            advance(REPLAY_REPEAT_MS);
+            return true;
+        default:
+            if (!stub_press(step->button, (step->press == REPLAY_PRESS_LONG) ?
+                                          STUB_PRESS_LONG : STUB_PRESS_SINGLE)) {
+                return false;
+            }
+            advance(RENDER_FRAME_MS);
+            return true;
+    }
+}
+
+// Counter readings at the start of a step
+typedef StepCost StepStart;
+
+static void step_begin(StepStart *start) {
+    start->ms = render_clock_ms() - s_simulated_ms;
+    start->formats = number_format_call_count();
+    start->texts = stub_text_count();
+    start->writes = storage_get_stats()->write_calls;
+}
+
+static void step_end(const StepStart *start, StepCost *cost) {
+    cost->ms += render_clock_ms() - s_simulated_ms - start->ms;
+    cost->formats += number_format_call_count() - start->formats;
+    cost->texts += stub_text_count() - start->texts;
+    cost->writes += storage_get_stats()->write_calls - start->writes;
+}
+
+// One pass of the trace on a fresh record and empty storage; false if a
+// step had no handler
+static bool replay_once(const ReplayTrace *trace) {
+    StepStart start;
+
+    storage_backend_memory_reset();
+    storage_set_backend(storage_backend_memory());
+    init_treatment_record(&s_record);
+
+    // Opening the window includes its first full frame
+    step_begin(&start);
+    pre_treatment_window_push(&s_record, NULL);
+    advance(RENDER_FRAME_MS);
+    step_end(&start, &s_costs[OPEN_ROW]);
+
+    bool ok = true;
+    for (int i = 0; i < trace->step_count && ok; i++) {
+        const ReplayStep *step = &trace->steps[i];
+
+        step_begin(&start);
+        for (int n = 0; n < step->count && ok; n++) {
+            ok = dispatch(step);
+        }
+        step_end(&start, &s_costs[i]);
+        if (!ok) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "replay %s: step %d has no handler", trace->name, i);
+        }
+    }
+
+    // Leave no write pending for the next backend, and no window behind
+    storage_flush_in_progress();
+    window_stack_pop_all(false);
+    return ok;
+}
+
+static bool replay_trace(const ReplayTrace *trace) {
+    memset(s_costs, 0, sizeof(s_costs));
+
+    for (int round = 0; round < REPLAY_ROUNDS; round++) {
+        if (!replay_once(trace)) {
+            return false;
+        }
+    }
+
+    const StepCost *open = &s_costs[OPEN_ROW];
+    APP_LOG(APP_LOG_LEVEL_INFO, "replay %s open: %ld us, %ld formats, %ld text draws, %ld writes",
+            trace->name, (long)(open->ms * 1000 / REPLAY_ROUNDS), (long)(open->formats / REPLAY_ROUNDS),
+            (long)(open->texts / REPLAY_ROUNDS), (long)(open->writes / REPLAY_ROUNDS));
+
+    uint32_t events = 0;
+    uint32_t total_ms = 0;
+    for (int i = 0; i < trace->step_count; i++) {
+        const ReplayStep *step = &trace->steps[i];
+        const StepCost *cost = &s_costs[i];
+        uint32_t step_events = step->count * REPLAY_ROUNDS;
+
+        APP_LOG(APP_LOG_LEVEL_INFO, "replay %s #%d %s %s%s x%d: %ld us/event, %ld formats, %ld text draws, %ld writes",
+                trace->name, i, s_target_names[step->target], s_button_names[step->button],
+                s_press_names[step->press], step->count,
+                (long)(cost->ms * 1000 / step_events), (long)(cost->formats / REPLAY_ROUNDS),
+                (long)(cost->texts / REPLAY_ROUNDS), (long)(cost->writes / REPLAY_ROUNDS));
+        events += step->count;
+        total_ms += cost->ms;
+    }
+    APP_LOG(APP_LOG_LEVEL_INFO, "replay %s: %ld events, %ld ms per replay",
+            trace->name, (long)events, (long)(total_ms / REPLAY_ROUNDS));
+    return true;
+}
+
+bool click_replay_run(void) {
+    bool ok = true;
+    for (size_t i = 0; i < ARRAY_LENGTH(s_corpus); i++) {
+        ok &= replay_trace(&s_corpus[i]);
+    }
+
+    history_window_deinit();
+    planner_window_deinit();
+    session_window_deinit();
+    post_treatment_window_deinit();
+    pre_treatment_window_deinit();
+    storage_backend_memory_reset();
+    storage_set_backend(storage_backend_persist());
+    return ok;
+}
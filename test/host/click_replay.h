@@ -0,0 +1,11 @@
+#pragma once
+
+#include <pebble.h>
+
+// Replay a corpus of recorded button traces (full treatment entry, a 10 kg
+// adjustment, field navigation) through the click handlers the windows'
+// click config providers subscribe, on the memory backend, and log the
+// time, formatter calls, text draws and flash writes of every step.
+// Restores the persist backend when done. Returns false if a step had no
+// subscribed handler.
+bool click_replay_run(void);
@@ -0,0 +1,101 @@
+#include "export_benchmark.h"
+#include "comm/history_export.h"
+#include "data/record_codec.h"
+#include "data/storage.h"
+#include "fixture.h"
+
+// Simulated link: fixed round trip plus serialization time, and every
+// SIM_LOSS_PERIOD-th send is NACKed
+#define SIM_ROUND_TRIP_MS   40
+#define SIM_BYTES_PER_MS    4
+#define SIM_LOSS_PERIOD     7
+#define SEED_RECORDS        200
+
+static const uint16_t s_chunk_records[] = { 1, 4, 10, 40 };
+
+static struct {
+    ExportTransport transport;
+    uint8_t config;
+    uint32_t sends;
+    bool in_flight;
+    uint16_t expected;
+    bool ok;
+} s_sim;
+
+static void start_config(void);
+
+static void deliver_callback(void *context) {
+    bool lost = (bool)(uintptr_t)context;
+    s_sim.in_flight = false;
+    if (lost) {
+        history_export_chunk_nacked();
+    } else {
+        history_export_chunk_acked();
+    }
+}
+
+static bool sim_send_chunk(uint16_t seq, uint16_t total, uint32_t first_seq,
+                           const uint8_t *payload, uint16_t length) {
+    if (s_sim.in_flight) {
+        // Outbox busy: the engine must wait for the previous result
+        return false;
+    }
+
+    s_sim.sends++;
+    s_sim.in_flight = true;
+    bool lost = (s_sim.sends % SIM_LOSS_PERIOD) == 0;
+    uint32_t delay = SIM_ROUND_TRIP_MS + length / SIM_BYTES_PER_MS;
+    app_timer_register(delay, deliver_callback, (void *)(uintptr_t)lost);
+    return true;
+}
+
+static void export_done(bool success, const ExportStats *stats) {
+    // Records per second as x10 fixed point
+    uint32_t rate_x10 = stats->elapsed_ms ? (stats->records_sent * 10000) / stats->elapsed_ms : 0;
+    APP_LOG(APP_LOG_LEVEL_INFO, "export bench: %d B chunks, %s, %ld records in %ld ms (%ld.%ld rec/s), %ld chunks, %ld retries",
+            (int)s_sim.transport.max_payload, success ? "ok" : "FAILED",
+            (long)stats->records_sent, (long)stats->elapsed_ms,
+            (long)(rate_x10 / 10), (long)(rate_x10 % 10),
+            (long)stats->chunks_sent, (long)stats->retries);
+    s_sim.ok &= success && stats->records_sent == s_sim.expected;
+
+    s_sim.config++;
+    start_config();
+}
+
+static void start_config(void) {
+    if (s_sim.config >= ARRAY_LENGTH(s_chunk_records)) {
+        return;
+    }
+
+    s_sim.transport.send_chunk = sim_send_chunk;
+    s_sim.transport.max_payload = s_chunk_records[s_sim.config] * RECORD_ENCODED_SIZE;
+    s_sim.sends = 0;
+    s_sim.in_flight = false;
+    if (!history_export_start(&s_sim.transport, 0, export_done)) {
+        APP_LOG(APP_LOG_LEVEL_WARNING, "export bench: export already running");
+        s_sim.ok = false;
+    }
+}
+
+bool export_benchmark_run(void) {
+    TreatmentRecord record;
+
+    storage_backend_memory_reset();
+    storage_set_backend(storage_backend_memory());
+    for (uint32_t seq = 1; seq <= SEED_RECORDS; seq++) {
+        fixture_make_record(&record, seq);
+        storage_save_to_history(&record);
+    }
+
+    memset(&s_sim, 0, sizeof(s_sim));
+    s_sim.expected = storage_get_history_count();
+    s_sim.ok = true;
+    start_config();
+    app_event_loop();
+
+    bool ok = s_sim.ok && s_sim.config == ARRAY_LENGTH(s_chunk_records);
+    storage_backend_memory_reset();
+    storage_set_backend(storage_backend_persist());
+    return ok;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <pebble.h>
+
+// Export a seeded history over a simulated lossy link at several chunk
+// sizes and log records/sec and retries for each. Runs on app timers until
+// every chunk size is done. Returns false if an export failed or sent a
+// different number of records than the history holds.
+bool export_benchmark_run(void);
@@ -0,0 +1,26 @@
+#include "fixture.h"
+
+#define FIXTURE_EPOCH  1700000000
+
+static uint32_t s_rng = 12345;
+
+void fixture_make_record(TreatmentRecord *record, uint32_t seq) {
+    uint32_t hash = seq * 2654435761u;
+    init_treatment_record(record);
+    record->dry_weight = 700 + (seq / 40) % 6;
+    record->pre_weight = record->dry_weight + 10 + (hash >> 8) % 35;
+    record->post_weight = record->dry_weight - 4 + (hash >> 16) % 9;
+    record->treatment_time = 180 + 15 * ((hash >> 4) % 5);
+    record->delta_selection = (hash >> 3) & 1;
+    record->timestamp = FIXTURE_EPOCH + (time_t)seq * 2 * 86400 + (time_t)(seq % 3) * 3600;
+    record->is_complete = true;
+}
+
+void fixture_seed(uint32_t seed) {
+    s_rng = seed;
+}
+
+uint32_t fixture_rand(void) {
+    s_rng = s_rng * 1103515245u + 12345u;
+    return (s_rng >> 16) & 0x7fff;
+}
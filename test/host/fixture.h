@@ -0,0 +1,17 @@
+#pragma once
+
+#include <pebble.h>
+#include "data/treatment_data.h"
+
+// Records and numbers shared by the host suites. Everything is derived
+// from its arguments, so a suite can rebuild the record it expects to
+// read back.
+
+// Plausible completed treatment number seq: weights a few kg either side
+// of a slowly moving dry weight, 3-4 hours in 15 minute steps, sessions
+// about two days apart. Timestamps increase with seq.
+void fixture_make_record(TreatmentRecord *record, uint32_t seq);
+
+// Repeatable pseudo-random numbers in 0..32767
+void fixture_seed(uint32_t seed);
+uint32_t fixture_rand(void);
@@ -0,0 +1,167 @@
+#include "format_benchmark.h"
+#include "ui/number_format.h"
+#include "ui/render_scheduler.h"
+
+#define WEIGHT_MIN          300
+#define WEIGHT_MAX          2000
+#define TIME_MIN            60
+#define TIME_MAX            480
+#define TIME_STEP           15
+#define DIFF_MAX            (WEIGHT_MAX - WEIGHT_MIN)
+// Percentages are swept exhaustively up to +/-2000.0% and sampled beyond
+#define PERCENT_DENSE_MAX   20000
+#define PERCENT_SPARSE_STEP 7
+#define SPEED_ROUNDS        5000
+
+// ---------------------------------------------------------------------------
+// snprintf reference (the previous implementation, with the sign of
+// values between -1 and 0 restored)
+// ---------------------------------------------------------------------------
+
+static const char *ref_sign(int32_t value, bool force_sign) {
+    if (value < 0) return "-";
+    return force_sign ? "+" : "";
+}
+
+static void ref_fixed(char *buffer, size_t size, int32_t value, int32_t scale, bool force_sign) {
+    int32_t magnitude = (value < 0) ? -value : value;
+    snprintf(buffer, size, (scale == 100) ? "%s%ld.%02ld" : "%s%ld.%ld",
+             ref_sign(value, force_sign), (long)(magnitude / scale), (long)(magnitude % scale));
+}
+
+static void ref_label(char *buffer, size_t size, const char *prefix, int32_t value,
+                      int32_t scale, bool force_sign, const char *suffix) {
+    char temp[16];
+    ref_fixed(temp, sizeof(temp), value, scale, force_sign);
+    snprintf(buffer, size, "%s%s%s", prefix, temp, suffix);
+}
+
+// ---------------------------------------------------------------------------
+// Equivalence sweep
+// ---------------------------------------------------------------------------
+
+static uint32_t s_checked;
+static uint32_t s_mismatches;
+
+static void expect_equal(const char *what, int32_t value, const char *got, const char *want) {
+    s_checked++;
+    if (strcmp(got, want) != 0) {
+        if (s_mismatches < 10) {
+            APP_LOG(APP_LOG_LEVEL_ERROR, "format %s(%ld): got '%s' want '%s'",
+                    what, (long)value, got, want);
+        }
+        s_mismatches++;
+    }
+}
+
+static void check_x10(int32_t value) {
+    char got[32];
+    char want[32];
+
+    format_weight(got, sizeof(got), value);
+    ref_fixed(want, sizeof(want), value, 10, false);
+    expect_equal("weight", value, got, want);
+
+    format_variance(got, sizeof(got), value);
+    ref_fixed(want, sizeof(want), value, 10, true);
+    expect_equal("variance", value, got, want);
+
+    format_fixed_label(got, sizeof(got), "Goal: ", value, FIXED_X10, " kg");
+    ref_label(want, sizeof(want), "Goal: ", value, 10, false, " kg");
+    expect_equal("label", value, got, want);
+}
+
+static void check_percentage(int32_t value) {
+    char got[32];
+    char want[32];
+
+    format_percentage(got, sizeof(got), value);
+    ref_label(want, sizeof(want), "", value, 10, false, "%");
+    expect_equal("percentage", value, got, want);
+}
+
+static void equivalence_sweep(void) {
+    char got[32];
+    char want[32];
+
+    s_checked = 0;
+    s_mismatches = 0;
+
+    // Weights plus every goal/removal/variance difference of two weights
+    for (int32_t v = -WEIGHT_MAX; v <= WEIGHT_MAX; v++) {
+        check_x10(v);
+    }
+
+    // Every minute of the allowed treatment range
+    for (int16_t minutes = TIME_MIN; minutes <= TIME_MAX; minutes++) {
+        format_time(got, sizeof(got), minutes);
+        snprintf(want, sizeof(want), "%d:%02d", minutes / 60, minutes % 60);
+        expect_equal("time", minutes, got, want);
+    }
+
+    // UFR for every goal at every selectable treatment time
+    for (int32_t k = -DIFF_MAX; k <= DIFF_MAX; k++) {
+        for (int32_t minutes = TIME_MIN; minutes <= TIME_MAX; minutes += TIME_STEP) {
+            int32_t ufr = (k * 600) / minutes;
+            format_ufr(got, sizeof(got), ufr);
+            ref_fixed(want, sizeof(want), ufr, 100, false);
+            expect_equal("ufr", ufr, got, want);
+        }
+    }
+
+    // Achievement percentage: (actual * 1000) / k
+    int32_t percent_max = DIFF_MAX * 1000;
+    for (int32_t p = -PERCENT_DENSE_MAX; p <= PERCENT_DENSE_MAX; p++) {
+        check_percentage(p);
+    }
+    for (int32_t p = PERCENT_DENSE_MAX; p <= percent_max; p += PERCENT_SPARSE_STEP) {
+        check_percentage(p);
+        check_percentage(-p);
+    }
+    check_percentage(percent_max);
+    check_percentage(-percent_max);
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "format equivalence: %ld values checked, %ld mismatches",
+            (long)s_checked, (long)s_mismatches);
+}
+
+// ---------------------------------------------------------------------------
+// Speed comparison
+// ---------------------------------------------------------------------------
+
+static void speed_comparison(void) {
+    char line[32];
+    uint32_t checksum = 0;
+
+    // One pre-window results refresh (four labels) per round
+    uint32_t start = render_clock_ms();
+    for (int32_t n = 0; n < SPEED_ROUNDS; n++) {
+        int32_t k = WEIGHT_MIN + n % DIFF_MAX;
+        ref_label(line, sizeof(line), "Goal: ", k, 10, false, " kg");
+        ref_label(line, sizeof(line), "Opt:  ", k - 2, 10, false, " kg");
+        ref_label(line, sizeof(line), "Pess: ", k + 2, 10, false, " kg");
+        ref_label(line, sizeof(line), "UFR:  ", (k * 600) / 240, 100, false, " kg/h");
+        checksum += line[6];
+    }
+    uint32_t snprintf_ms = render_clock_ms() - start;
+
+    start = render_clock_ms();
+    for (int32_t n = 0; n < SPEED_ROUNDS; n++) {
+        int32_t k = WEIGHT_MIN + n % DIFF_MAX;
+        format_fixed_label(line, sizeof(line), "Goal: ", k, FIXED_X10, " kg");
+        format_fixed_label(line, sizeof(line), "Opt:  ", k - 2, FIXED_X10, " kg");
+        format_fixed_label(line, sizeof(line), "Pess: ", k + 2, FIXED_X10, " kg");
+        format_fixed_label(line, sizeof(line), "UFR:  ", (k * 600) / 240, FIXED_X100, " kg/h");
+        checksum += line[6];
+    }
+    uint32_t fixed_ms = render_clock_ms() - start;
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "format bench: %d refreshes, snprintf %ld ms, fixed %ld ms (checksum %ld)",
+            SPEED_ROUNDS, (long)snprintf_ms, (long)fixed_ms, (long)checksum);
+}
+
+bool format_benchmark_run(void) {
+    equivalence_sweep();
+    speed_comparison();
+    return s_mismatches == 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <pebble.h>
+
+// Check the printf-free formatters against snprintf reference output over
+// every value the app can produce, then time both implementations. Returns
+// false on any mismatch.
+bool format_benchmark_run(void);
@@ -0,0 +1,95 @@
+#include "heap_cycle_test.h"
+#include "data/storage.h"
+#include "ui/heap_stats.h"
+#include "windows/pre_treatment_window.h"
+#include "windows/post_treatment_window.h"
+#include "windows/session_window.h"
+#include "windows/planner_window.h"
+#include "windows/history_window.h"
+
+#define CYCLES          5
+#define STEP_MS         500     // Long enough for the push/pop animations
+
+typedef enum {
+    WINDOW_POST,
+    WINDOW_SESSION,
+    WINDOW_PLANNER,
+    WINDOW_HISTORY,
+    WINDOW_COUNT
+} CycledWindow;
+
+static struct {
+    TreatmentRecord record;
+    uint16_t step;              // Push and pop of one window per two steps
+    size_t used_after_first;    // heap_bytes_used() after the first cycle
+    bool ok;
+} s_cycle;
+
+static void push_window(CycledWindow window) {
+    switch (window) {
+        case WINDOW_POST:    post_treatment_window_push(&s_cycle.record); break;
+        case WINDOW_SESSION: session_window_push(&s_cycle.record);        break;
+        case WINDOW_PLANNER: planner_window_push(&s_cycle.record);        break;
+        default:             history_window_push();                      break;
+    }
+}
+
+static void report(void) {
+    const HeapStats *stats = heap_stats_get();
+    size_t used = heap_bytes_used();
+    int growth = (int)used - (int)s_cycle.used_after_first;
+    s_cycle.ok = growth == 0 && stats->peak_used <= HEAP_BUDGET_BYTES;
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "heap cycle: %d cycles, %d bytes used after the first, %d after the last (%+d)",
+            CYCLES, (int)s_cycle.used_after_first, (int)used, growth);
+    APP_LOG(APP_LOG_LEVEL_INFO, "heap cycle: peak %d bytes at %s, budget %d: %s",
+            (int)stats->peak_used, stats->peak_at, HEAP_BUDGET_BYTES,
+            s_cycle.ok ? "ok" : "FAILED");
+}
+
+static void step_callback(void *context) {
+    uint16_t step = s_cycle.step++;
+    int index = step / 2;
+
+    if (step % 2 == 0) {
+        push_window((CycledWindow)(index % WINDOW_COUNT));
+    } else {
+        window_stack_pop(false);
+        if (index + 1 == WINDOW_COUNT) {
+            s_cycle.used_after_first = heap_bytes_used();
+        }
+        if (index + 1 == CYCLES * WINDOW_COUNT) {
+            report();
+            return;
+        }
+    }
+    app_timer_register(STEP_MS, step_callback, NULL);
+}
+
+bool heap_cycle_test_run(void) {
+    storage_backend_memory_reset();
+    storage_set_backend(storage_backend_memory());
+    init_treatment_record(&s_cycle.record);
+    s_cycle.step = 0;
+    s_cycle.ok = false;
+    size_t before = heap_bytes_used();
+
+    pre_treatment_window_push(&s_cycle.record, NULL);
+    app_timer_register(STEP_MS, step_callback, NULL);
+    app_event_loop();
+
+    window_stack_pop_all(false);
+    history_window_deinit();
+    planner_window_deinit();
+    session_window_deinit();
+    post_treatment_window_deinit();
+    pre_treatment_window_deinit();
+    storage_backend_memory_reset();
+    storage_set_backend(storage_backend_persist());
+    if (heap_bytes_used() != before) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "heap cycle: %d bytes still used after deinit",
+                (int)(heap_bytes_used() - before));
+        s_cycle.ok = false;
+    }
+    return s_cycle.ok;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <pebble.h>
+
+// Push the pre-treatment window, then push and pop every secondary window
+// over it for a number of cycles on app timers. Fails if the heap grew
+// after the first cycle or the peak went over HEAP_BUDGET_BYTES. Heap use
+// is what the stub counts: the app's own allocations plus stub layers and
+// windows, whose sizes only approximate the firmware's.
+bool heap_cycle_test_run(void);
@@ -0,0 +1,30 @@
+// Host suites: the watch code built against the stub SDK (stub/), run on
+// Linux. Usage: host_suites [flash directory for the file backend]
+#include "stub/stub.h"
+#include "storage_backend_file.h"
+#include "storage_benchmark.h"
+#include "format_benchmark.h"
+#include "export_benchmark.h"
+#include "storage_fault_test.h"
+#include "metrics_benchmark.h"
+#include "heap_cycle_test.h"
+#include "click_replay.h"
+#include "migration_test.h"
+
+int main(int argc, char **argv) {
+    const char *flash = (argc > 1) ? argv[1] : "flash";
+    bool ok = true;
+
+    ok &= storage_benchmark_run("memory", storage_backend_memory(), storage_backend_memory_reset);
+    ok &= storage_benchmark_run("file", storage_backend_file(flash), storage_backend_file_reset);
+    ok &= format_benchmark_run();
+    ok &= export_benchmark_run();
+    ok &= storage_fault_test_run();
+    ok &= metrics_benchmark_run();
+    ok &= heap_cycle_test_run();
+    ok &= click_replay_run();
+    ok &= migration_test_run();
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "host suites: %s", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+#include "metrics_benchmark.h"
+#include "data/metrics_batch.h"
+#include "ui/render_scheduler.h"
+#include "fixture.h"
+
+#define WEIGHT_MIN          300
+#define WEIGHT_MAX          2000
+#define DIFF_MAX            (WEIGHT_MAX - WEIGHT_MIN)
+#define PLAN_ROUNDS         100000  // Sized for a desktop CPU
+#define RECORD_ROUNDS       100000
+
+// Shared with the loops below; too big for the app stack
+static MetricsBatch s_batch;
+static CalculatedMetrics s_reference[METRICS_BATCH_MAX];
+static TreatmentRecord s_records[METRICS_BATCH_MAX];
+static bool s_ok;
+
+// UFR calculate_pre_metrics() gives for a goal of k at minutes
+static int32_t reference_ufr(int32_t k, int16_t minutes) {
+    TreatmentRecord record;
+    CalculatedMetrics metrics;
+    init_treatment_record(&record);
+    record.pre_weight = record.dry_weight + k;
+    record.treatment_time = minutes;
+    calculate_pre_metrics(&record, &metrics);
+    return metrics.ufr;
+}
+
+// ---------------------------------------------------------------------------
+// Equivalence sweep
+// ---------------------------------------------------------------------------
+
+static void equivalence_sweep(void) {
+    TreatmentRecord record;
+    CalculatedMetrics metrics;
+    uint32_t checked = 0;
+    uint32_t mismatches = 0;
+
+    init_treatment_record(&record);
+    record.dry_weight = WEIGHT_MIN;
+
+    for (int32_t k = -DIFF_MAX; k <= DIFF_MAX; k++) {
+        record.pre_weight = WEIGHT_MIN + k;
+        metrics_batch_plan(&s_batch, &record);
+
+        for (int row = 0; row < s_batch.count; row++) {
+            TreatmentRecord scenario = record;
+            scenario.treatment_time = s_batch.minutes[row];
+            scenario.delta_selection = row / METRICS_PLAN_DURATIONS;
+            calculate_pre_metrics(&scenario, &metrics);
+
+            checked++;
+            if (s_batch.k_goal[row] != metrics.k_goal ||
+                s_batch.optimistic[row] != metrics.optimistic ||
+                s_batch.pessimistic[row] != metrics.pessimistic ||
+                s_batch.ufr[row] != metrics.ufr ||
+                s_batch.ufr_optimistic[row] != reference_ufr(metrics.optimistic, scenario.treatment_time) ||
+                s_batch.ufr_pessimistic[row] != reference_ufr(metrics.pessimistic, scenario.treatment_time)) {
+                if (mismatches < 10) {
+                    APP_LOG(APP_LOG_LEVEL_ERROR, "metrics k=%ld %d min delta %d: batch differs",
+                            (long)k, scenario.treatment_time, scenario.delta_selection);
+                }
+                mismatches++;
+            }
+        }
+    }
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "metrics equivalence: %ld scenarios checked, %ld mismatches",
+            (long)checked, (long)mismatches);
+    s_ok &= mismatches == 0;
+}
+
+// ---------------------------------------------------------------------------
+// Speed comparison
+// ---------------------------------------------------------------------------
+
+// The planner table built one calculate_pre_metrics() call per value, as the
+// pre-treatment window computes a single scenario
+static int32_t plan_with_loop(const TreatmentRecord *base) {
+    TreatmentRecord scenario = *base;
+    int32_t checksum = 0;
+
+    for (int sel = 0; sel < METRICS_PLAN_DELTAS; sel++) {
+        scenario.delta_selection = sel;
+        for (int i = 0; i < METRICS_PLAN_DURATIONS; i++) {
+            CalculatedMetrics *metrics = &s_reference[metrics_plan_row(sel, i)];
+            scenario.treatment_time = METRICS_PLAN_MIN_MINUTES + i * METRICS_PLAN_STEP_MINUTES;
+            calculate_pre_metrics(&scenario, metrics);
+            checksum += metrics->ufr;
+            checksum += reference_ufr(metrics->optimistic, scenario.treatment_time);
+            checksum += reference_ufr(metrics->pessimistic, scenario.treatment_time);
+        }
+    }
+    return checksum;
+}
+
+static int32_t plan_with_batch(const TreatmentRecord *base) {
+    int32_t checksum = 0;
+    metrics_batch_plan(&s_batch, base);
+    for (int row = 0; row < s_batch.count; row++) {
+        checksum += s_batch.ufr[row] + s_batch.ufr_optimistic[row] + s_batch.ufr_pessimistic[row];
+    }
+    return checksum;
+}
+
+static void speed_comparison(void) {
+    TreatmentRecord record;
+    init_treatment_record(&record);
+
+    // Full planner table (58 scenarios, three UFRs each) per round
+    int32_t loop_checksum = 0;
+    uint32_t start = render_clock_ms();
+    for (int32_t n = 0; n < PLAN_ROUNDS; n++) {
+        record.pre_weight = record.dry_weight + n % 60;
+        loop_checksum += plan_with_loop(&record);
+    }
+    uint32_t loop_ms = render_clock_ms() - start;
+
+    int32_t batch_checksum = 0;
+    start = render_clock_ms();
+    for (int32_t n = 0; n < PLAN_ROUNDS; n++) {
+        record.pre_weight = record.dry_weight + n % 60;
+        batch_checksum += plan_with_batch(&record);
+    }
+    uint32_t batch_ms = render_clock_ms() - start;
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "metrics plan bench: %d tables, loop %ld ms, batch %ld ms (%s)",
+            PLAN_ROUNDS, (long)loop_ms, (long)batch_ms,
+            (loop_checksum == batch_checksum) ? "same results" : "RESULTS DIFFER");
+    s_ok &= loop_checksum == batch_checksum;
+
+    // History analytics: a batch of stored-record scenarios per round
+    for (int i = 0; i < METRICS_BATCH_MAX; i++) {
+        fixture_make_record(&s_records[i], i);
+    }
+
+    loop_checksum = 0;
+    start = render_clock_ms();
+    for (int32_t n = 0; n < RECORD_ROUNDS; n++) {
+        for (int i = 0; i < METRICS_BATCH_MAX; i++) {
+            calculate_pre_metrics(&s_records[i], &s_reference[i]);
+            loop_checksum += s_reference[i].ufr + s_reference[i].pessimistic;
+        }
+    }
+    loop_ms = render_clock_ms() - start;
+
+    batch_checksum = 0;
+    start = render_clock_ms();
+    for (int32_t n = 0; n < RECORD_ROUNDS; n++) {
+        metrics_batch_clear(&s_batch);
+        for (int i = 0; i < METRICS_BATCH_MAX; i++) {
+            metrics_batch_add(&s_batch, &s_records[i]);
+        }
+        metrics_batch_run(&s_batch);
+        for (int i = 0; i < s_batch.count; i++) {
+            batch_checksum += s_batch.ufr[i] + s_batch.pessimistic[i];
+        }
+    }
+    batch_ms = render_clock_ms() - start;
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "metrics record bench: %d x %d records, loop %ld ms, batch %ld ms (%s)",
+            RECORD_ROUNDS, METRICS_BATCH_MAX, (long)loop_ms, (long)batch_ms,
+            (loop_checksum == batch_checksum) ? "same results" : "RESULTS DIFFER");
+    s_ok &= loop_checksum == batch_checksum;
+}
+
+bool metrics_benchmark_run(void) {
+    s_ok = true;
+    equivalence_sweep();
+    speed_comparison();
+    return s_ok;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <pebble.h>
+
+// Check the batch metrics kernel against calculate_pre_metrics() for every
+// goal the weight fields allow at every planned time and delta, then time a
+// full planner table and a batch of history-like records both ways. Returns
+// false if the kernel disagrees anywhere.
+bool metrics_benchmark_run(void);
@@ -0,0 +1,135 @@
+#include "migration_test.h"
+#include "data/storage.h"
+#include "fixture.h"
+
+#define MIGRATION_FIRST_FORMAT  2
+#define MIGRATION_LAST_FORMAT   5
+#define MIGRATION_PER_FORMAT    45      // A page and a half in each format
+#define MIGRATION_CHUNK         8
+
+// Each upgrade changes the dry weight differently, so a record comes out
+// right only if exactly the upgrades after its format ran, in order
+static void upgrade_2_to_3(TreatmentRecord *record) {
+    record->dry_weight += 1;
+}
+
+static void upgrade_3_to_4(TreatmentRecord *record) {
+    record->dry_weight *= 2;
+}
+
+static void upgrade_4_to_5(TreatmentRecord *record) {
+    record->dry_weight += 3;
+}
+
+// Formats 2-5; all keep the built-in record layout
+static LogFormat s_formats[MIGRATION_LAST_FORMAT - MIGRATION_FIRST_FORMAT + 1];
+static LogSchema s_schema;
+
+static void use_format(uint8_t current) {
+    s_schema.oldest = MIGRATION_FIRST_FORMAT;
+    s_schema.current = current;
+    s_schema.formats = s_formats;
+    history_log_set_schema(&s_schema);
+
+    // Reopen the log, as after an app update
+    storage_set_backend(storage_backend_memory());
+}
+
+static uint8_t format_of_seq(uint32_t seq) {
+    return MIGRATION_FIRST_FORMAT + seq / MIGRATION_PER_FORMAT;
+}
+
+// The record as read once format 5 is current
+static void expected_record(uint32_t seq, TreatmentRecord *record) {
+    fixture_make_record(record, seq);
+    for (uint8_t format = format_of_seq(seq); format < MIGRATION_LAST_FORMAT; format++) {
+        s_formats[format - MIGRATION_FIRST_FORMAT].upgrade(record);
+    }
+}
+
+// Reads needed to open the log
+static uint32_t open_cost(void) {
+    storage_set_backend(storage_backend_memory());
+    storage_reset_stats();
+    storage_get_history_count();
+    return storage_get_stats()->read_calls;
+}
+
+// NULL if every record and the statistics match, else what is wrong
+static const char *verify(void) {
+    int count = storage_get_history_count();
+    if (count != (MIGRATION_LAST_FORMAT - MIGRATION_FIRST_FORMAT) * MIGRATION_PER_FORMAT) {
+        return "record count";
+    }
+
+    TreatmentRecord chunk[MIGRATION_CHUNK];
+    TreatmentRecord expected;
+    HistoryStats expected_stats;
+    HistoryStats stats;
+    history_stats_init(&expected_stats);
+    for (int i = 0; i < count; i += MIGRATION_CHUNK) {
+        int n = storage_load_history_range(i, MIGRATION_CHUNK, chunk);
+        for (int k = 0; k < n; k++) {
+            expected_record(i + k, &expected);
+            if (!treatment_records_equal(&chunk[k], &expected)) {
+                return "wrong record";
+            }
+            history_stats_add(&expected_stats, &expected);
+        }
+    }
+
+    storage_load_history_stats(&stats);
+    if (memcmp(&stats, &expected_stats, sizeof(stats)) != 0) {
+        return "stats not rebuilt";
+    }
+    return NULL;
+}
+
+bool migration_test_run(void) {
+    const LogFormat *builtin = &history_log_get_schema()->formats[0];
+    void (*const upgrades[])(TreatmentRecord *) = { upgrade_2_to_3, upgrade_3_to_4, upgrade_4_to_5, NULL };
+    for (size_t i = 0; i < ARRAY_LENGTH(s_formats); i++) {
+        s_formats[i].decode = builtin->decode;
+        s_formats[i].upgrade = upgrades[i];
+    }
+
+    storage_backend_memory_reset();
+    uint32_t seq = 0;
+    for (uint8_t format = MIGRATION_FIRST_FORMAT; format < MIGRATION_LAST_FORMAT; format++) {
+        use_format(format);
+        for (int i = 0; i < MIGRATION_PER_FORMAT; i++, seq++) {
+            TreatmentRecord record;
+            fixture_make_record(&record, seq);
+            storage_save_to_history(&record);
+        }
+    }
+
+    use_format(MIGRATION_LAST_FORMAT);
+    uint32_t open_before = open_cost();
+    const char *lazy = verify();
+
+    storage_reset_stats();
+    int steps = 0;
+    int left;
+    do {
+        left = storage_migrate_step();
+        steps++;
+    } while (left > 0 && steps <= HISTORY_LOG_MAX_PAGES);
+    uint32_t rewrite_writes = storage_get_stats()->write_calls;
+
+    uint32_t open_after = open_cost();
+    const char *rewritten = verify();
+    int left_after = storage_migrate_step();
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "migration test: lazy read %s, %d rewrite steps (%ld writes), rewritten log %s",
+            lazy ? lazy : "ok", steps, (long)rewrite_writes, rewritten ? rewritten : "ok");
+    APP_LOG(APP_LOG_LEVEL_INFO, "  open: %ld reads with old pages, %ld after rewrite, %d old pages left",
+            (long)open_before, (long)open_after, left_after);
+
+    history_log_set_schema(NULL);
+    storage_backend_memory_reset();
+    storage_set_backend(storage_backend_persist());
+    storage_reset_stats();
+
+    return !lazy && !rewritten && open_after == open_before && left_after == 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <pebble.h>
+
+// Write history pages in formats 2, 3 and 4 of a made-up schema on the
+// memory backend, then read them with format 5 current, so records go
+// through chains of one to three upgrades. Checks every record and the
+// rebuilt statistics, that opening the log costs the same reads with old
+// pages as without, and that the background rewrite converts every page
+// without changing what is read. Restores the built-in schema and the
+// persist backend when done. Returns false if any check failed.
+bool migration_test_run(void);
@@ -0,0 +1,96 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "storage_backend_file.h"
+
+#define FILE_PATH_MAX  256
+#define FILE_NAME_MAX  16
+
+static char s_directory[FILE_PATH_MAX - FILE_NAME_MAX];
+
+static void key_path(uint32_t key, char *path) {
+    snprintf(path, FILE_PATH_MAX, "%s/%08lx", s_directory, (unsigned long)key);
+}
+
+static bool file_exists(uint32_t key) {
+    char path[FILE_PATH_MAX];
+    key_path(key, path);
+    return access(path, F_OK) == 0;
+}
+
+static int file_read_data(uint32_t key, void *buffer, size_t size) {
+    char path[FILE_PATH_MAX];
+    key_path(key, path);
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return E_DOES_NOT_EXIST;
+    }
+    size_t n = fread(buffer, 1, MIN(size, PERSIST_DATA_MAX_LENGTH), file);
+    fclose(file);
+    return (int)n;
+}
+
+static int file_write_data(uint32_t key, const void *data, size_t size) {
+    char path[FILE_PATH_MAX];
+    key_path(key, path);
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return E_OUT_OF_STORAGE;
+    }
+    size = MIN(size, PERSIST_DATA_MAX_LENGTH);
+    size_t n = fwrite(data, 1, size, file);
+    if (fclose(file) != 0 || n != size) {
+        return E_OUT_OF_STORAGE;
+    }
+    return (int)n;
+}
+
+static int32_t file_read_int(uint32_t key) {
+    int32_t value = 0;
+    file_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+static status_t file_write_int(uint32_t key, int32_t value) {
+    int bytes = file_write_data(key, &value, sizeof(value));
+    return (bytes == (int)sizeof(value)) ? S_SUCCESS : E_OUT_OF_STORAGE;
+}
+
+static status_t file_remove(uint32_t key) {
+    char path[FILE_PATH_MAX];
+    key_path(key, path);
+    return (unlink(path) == 0) ? S_SUCCESS : E_DOES_NOT_EXIST;
+}
+
+static const StorageBackend s_file_backend = {
+    .exists = file_exists,
+    .read_data = file_read_data,
+    .write_data = file_write_data,
+    .read_int = file_read_int,
+    .write_int = file_write_int,
+    .remove = file_remove
+};
+
+const StorageBackend *storage_backend_file(const char *directory) {
+    snprintf(s_directory, sizeof(s_directory), "%s", directory);
+    mkdir(s_directory, 0755);
+    return &s_file_backend;
+}
+
+void storage_backend_file_reset(void) {
+    DIR *dir = opendir(s_directory);
+    if (!dir) {
+        return;
+    }
+    struct dirent *entry;
+    char path[FILE_PATH_MAX * 2];
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", s_directory, entry->d_name);
+            unlink(path);
+        }
+    }
+    closedir(dir);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <pebble.h>
+#include "data/storage_backend.h"
+
+// Host backend keeping each key in its own file under a directory, so
+// every read and write is a real file system call. The directory is
+// created if missing; storage_backend_file_reset() deletes every key file.
+const StorageBackend *storage_backend_file(const char *directory);
+void storage_backend_file_reset(void);
@@ -0,0 +1,346 @@
+#include "storage_benchmark.h"
+#include "data/storage.h"
+#include "data/record_codec.h"
+#include "ui/render_scheduler.h"
+#include "fixture.h"
+
+#define BENCH_TREATMENTS        2000    // Fills the history log and evicts many times
+#define BENCH_EDITS_PER_SESSION 10      // In-progress saves per treatment
+#define BENCH_CODEC_ROUNDS      20000   // Encode/decode iterations
+#define BENCH_LOG_PAGES         200     // Pages filled by the log benchmark
+#define SESSIONS_PER_WEEK       3
+#define BENCH_RANGE_QUERIES     200     // Date-range queries per width
+#define BENCH_RANGE_CHUNK       16      // Records per read in the linear scan
+
+typedef struct {
+    const char *name;
+    uint32_t ops;
+    uint32_t start_ms;
+    uint32_t elapsed_ms;
+    StorageStats before;
+    StorageStats delta;
+} BenchPhase;
+
+static const StorageBackend *s_backend;
+static bool s_ok;
+
+static void phase_begin(BenchPhase *phase, const char *name) {
+    phase->name = name;
+    phase->ops = 0;
+    phase->before = *storage_get_stats();
+    phase->start_ms = render_clock_ms();
+}
+
+static void phase_end(BenchPhase *phase) {
+    phase->elapsed_ms = render_clock_ms() - phase->start_ms;
+    const StorageStats *after = storage_get_stats();
+    phase->delta.exists_calls = after->exists_calls - phase->before.exists_calls;
+    phase->delta.read_calls = after->read_calls - phase->before.read_calls;
+    phase->delta.write_calls = after->write_calls - phase->before.write_calls;
+    phase->delta.delete_calls = after->delete_calls - phase->before.delete_calls;
+    phase->delta.metadata_reads = after->metadata_reads - phase->before.metadata_reads;
+    phase->delta.bytes_read = after->bytes_read - phase->before.bytes_read;
+    phase->delta.bytes_written = after->bytes_written - phase->before.bytes_written;
+    phase->delta.coalesced_writes = after->coalesced_writes - phase->before.coalesced_writes;
+    phase->delta.skipped_writes = after->skipped_writes - phase->before.skipped_writes;
+}
+
+// Per-op ratio as x100 fixed point, printed as "X.XX"
+static void log_ratio(const char *name, const char *what, uint32_t total, uint32_t ops) {
+    uint32_t x100 = ops ? (total * 100) / ops : 0;
+    APP_LOG(APP_LOG_LEVEL_INFO, "  %s %s/op: %ld.%02ld",
+            name, what, (long)(x100 / 100), (long)(x100 % 100));
+}
+
+static void phase_report(const BenchPhase *phase) {
+    uint32_t us_per_op = phase->ops ? (phase->elapsed_ms * 1000) / phase->ops : 0;
+    APP_LOG(APP_LOG_LEVEL_INFO, "storage bench %s: %ld ops in %ld ms (%ld us/op)",
+            phase->name, (long)phase->ops, (long)phase->elapsed_ms, (long)us_per_op);
+    log_ratio(phase->name, "exists", phase->delta.exists_calls, phase->ops);
+    log_ratio(phase->name, "reads", phase->delta.read_calls, phase->ops);
+    log_ratio(phase->name, "metadata reads", phase->delta.metadata_reads, phase->ops);
+    log_ratio(phase->name, "writes", phase->delta.write_calls, phase->ops);
+    log_ratio(phase->name, "bytes written", phase->delta.bytes_written, phase->ops);
+    if (phase->delta.coalesced_writes) {
+        log_ratio(phase->name, "coalesced", phase->delta.coalesced_writes, phase->ops);
+    }
+    if (phase->delta.skipped_writes) {
+        log_ratio(phase->name, "skipped", phase->delta.skipped_writes, phase->ops);
+    }
+}
+
+// Regression check on a steady-state phase: no metadata reads and at most
+// max_reads_x100 / 100 backend reads per operation
+static void expect_reads(const BenchPhase *phase, uint32_t max_reads_x100) {
+    uint32_t reads_x100 = phase->ops ? (phase->delta.read_calls * 100) / phase->ops : 0;
+    bool ok = phase->delta.metadata_reads == 0 && phase->delta.exists_calls == 0 &&
+              reads_x100 <= max_reads_x100;
+    APP_LOG(APP_LOG_LEVEL_INFO, "  %s steady state: %s", phase->name, ok ? "ok" : "REGRESSION");
+    s_ok &= ok;
+}
+
+// Records with from <= timestamp < to, checking every stored record's
+// timestamp (the cost without the index)
+static int linear_between(time_t from, time_t to, int stored) {
+    static TreatmentRecord chunk[BENCH_RANGE_CHUNK];
+    int found = 0;
+    for (int start = 0; start < stored; start += BENCH_RANGE_CHUNK) {
+        int n = storage_load_history_range(start, BENCH_RANGE_CHUNK, chunk);
+        for (int i = 0; i < n; i++) {
+            if (chunk[i].timestamp >= from && chunk[i].timestamp < to) {
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+// Date-range queries of several widths ending anywhere in the stored
+// history, through the week index and by linear scan
+static void range_benchmark(int stored) {
+    static const uint8_t widths_days[] = { 1, 7, 30, 90 };
+    static TreatmentRecord matches[BENCH_RANGE_CHUNK * 4];
+    TreatmentRecord oldest;
+    TreatmentRecord newest;
+
+    if (!storage_load_from_history(0, &oldest) || !storage_load_from_history(stored - 1, &newest)) {
+        return;
+    }
+    uint32_t span = (uint32_t)(newest.timestamp - oldest.timestamp);
+
+    for (size_t w = 0; w < ARRAY_LENGTH(widths_days); w++) {
+        time_t width = (time_t)widths_days[w] * 86400;
+        BenchPhase indexed;
+        BenchPhase linear;
+        uint32_t found = 0;
+
+        // Same query sequence for both
+        fixture_seed(777 + w);
+        phase_begin(&indexed, "load_history_between");
+        for (int q = 0; q < BENCH_RANGE_QUERIES; q++) {
+            time_t to = oldest.timestamp + ((fixture_rand() << 15) | fixture_rand()) % span + 1;
+            found += storage_load_history_between(to - width, to, ARRAY_LENGTH(matches), matches);
+            indexed.ops++;
+        }
+        phase_end(&indexed);
+
+        fixture_seed(777 + w);
+        uint32_t linear_found = 0;
+        phase_begin(&linear, "linear scan");
+        for (int q = 0; q < BENCH_RANGE_QUERIES; q++) {
+            time_t to = oldest.timestamp + ((fixture_rand() << 15) | fixture_rand()) % span + 1;
+            linear_found += linear_between(to - width, to, stored);
+            linear.ops++;
+        }
+        phase_end(&linear);
+
+        APP_LOG(APP_LOG_LEVEL_INFO, "range bench %d days over %d records: %ld matches/query, %s",
+                widths_days[w], stored, (long)(found / BENCH_RANGE_QUERIES),
+                (found == linear_found) ? "results agree" : "MISMATCH");
+        s_ok &= found == linear_found;
+        phase_report(&indexed);
+        log_ratio(indexed.name, "bytes read", indexed.delta.bytes_read, indexed.ops);
+        phase_report(&linear);
+        log_ratio(linear.name, "bytes read", linear.delta.bytes_read, linear.ops);
+    }
+}
+
+// Encode/decode throughput and stored size versus the raw struct
+static void codec_benchmark(void) {
+    TreatmentRecord record;
+    TreatmentRecord decoded;
+    uint8_t buffer[RECORD_ENCODED_SIZE];
+    uint32_t checksum = 0;
+
+    fixture_make_record(&record, 1);
+
+    uint32_t start = render_clock_ms();
+    for (int n = 0; n < BENCH_CODEC_ROUNDS; n++) {
+        record.pre_weight = 700 + (n & 0xFF);
+        checksum += record_encode(&record, buffer) + buffer[1];
+    }
+    uint32_t encode_ms = render_clock_ms() - start;
+
+    start = render_clock_ms();
+    for (int n = 0; n < BENCH_CODEC_ROUNDS; n++) {
+        buffer[1] = (uint8_t)n;
+        record_decode(buffer, sizeof(buffer), &decoded);
+        checksum += decoded.pre_weight;
+    }
+    uint32_t decode_ms = render_clock_ms() - start;
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "codec bench: %d rounds, encode %ld ms, decode %ld ms (checksum %ld)",
+            BENCH_CODEC_ROUNDS, (long)encode_ms, (long)decode_ms, (long)checksum);
+    APP_LOG(APP_LOG_LEVEL_INFO, "  bytes/record: %d encoded vs %d raw struct",
+            RECORD_ENCODED_SIZE, (int)sizeof(TreatmentRecord));
+}
+
+// Sequential append and full-scan decode of compressed log pages in RAM
+static void log_benchmark(void) {
+    LogPage *page = malloc(sizeof(LogPage));
+    if (!page) {
+        return;
+    }
+    TreatmentRecord record;
+    uint32_t records = 0;
+    uint32_t bytes = 0;
+    uint32_t decode_ms = 0;
+    uint32_t checksum = 0;
+    int n = 0;
+
+    uint32_t start = render_clock_ms();
+    for (int p = 0; p < BENCH_LOG_PAGES; p++) {
+        history_log_page_init(page, records);
+        fixture_make_record(&record, n);
+        while (history_log_page_append(page, &record)) {
+            fixture_make_record(&record, ++n);
+        }
+        records += page->count;
+        bytes += page->length;
+
+        // Time the scan separately from the appends
+        uint32_t scan_start = render_clock_ms();
+        LogCursor cursor;
+        history_log_cursor_init(&cursor, page);
+        while (history_log_cursor_next(&cursor, &record)) {
+            checksum += record.post_weight;
+        }
+        decode_ms += render_clock_ms() - scan_start;
+    }
+    uint32_t append_ms = render_clock_ms() - start - decode_ms;
+    free(page);
+
+    // Bytes per record as x100 fixed point, including page headers
+    uint32_t size_x100 = records ? (bytes * 100) / records : 0;
+    APP_LOG(APP_LOG_LEVEL_INFO, "log bench: %ld records in %d pages, append %ld ms, scan %ld ms (checksum %ld)",
+            (long)records, BENCH_LOG_PAGES, (long)append_ms, (long)decode_ms, (long)checksum);
+    APP_LOG(APP_LOG_LEVEL_INFO, "  bytes/record: %ld.%02ld compressed vs %d encoded, %ld records/page",
+            (long)(size_x100 / 100), (long)(size_x100 % 100), RECORD_ENCODED_SIZE,
+            (long)(records / BENCH_LOG_PAGES));
+}
+
+bool storage_benchmark_run(const char *name, const StorageBackend *backend, void (*reset)(void)) {
+    BenchPhase phase;
+    TreatmentRecord record;
+
+    APP_LOG(APP_LOG_LEVEL_INFO, "storage bench on the %s backend", name);
+    s_backend = backend;
+    s_ok = true;
+    reset();
+    storage_set_backend(backend);
+    storage_reset_stats();
+
+    // In-progress saves as produced by editing a field
+    phase_begin(&phase, "save_in_progress");
+    for (int n = 0; n < BENCH_TREATMENTS; n++) {
+        fixture_make_record(&record, n);
+        for (int e = 0; e < BENCH_EDITS_PER_SESSION; e++) {
+            record.pre_weight++;
+            storage_save_in_progress(&record);
+            phase.ops++;
+        }
+    }
+    phase_end(&phase);
+    phase_report(&phase);
+
+    // The same edits through the write-behind path, flushed once per session
+    phase_begin(&phase, "save_in_progress_deferred");
+    for (int n = 0; n < BENCH_TREATMENTS; n++) {
+        fixture_make_record(&record, n);
+        for (int e = 0; e < BENCH_EDITS_PER_SESSION; e++) {
+            record.pre_weight++;
+            storage_save_in_progress_deferred(&record);
+            phase.ops++;
+        }
+        storage_flush_in_progress();
+    }
+    phase_end(&phase);
+    phase_report(&phase);
+
+    // Relaunches with a treatment in progress: the startup path in init()
+    UiSnapshot ui;
+    phase_begin(&phase, "startup");
+    for (int n = 0; n < BENCH_TREATMENTS; n++) {
+        storage_set_backend(s_backend);     // Drops RAM state
+        storage_load_in_progress(&record, &ui);
+        storage_save_ui_deferred(&ui);
+        storage_flush_in_progress();
+        phase.ops++;
+    }
+    phase_end(&phase);
+    phase_report(&phase);
+
+    // Appends, filling the log and evicting its oldest pages. The first
+    // opens the log; from then on each reads only the tail page, plus the
+    // page it evicts and a rescan when that took the min or max.
+    fixture_make_record(&record, 0);
+    storage_save_to_history(&record);
+    phase_begin(&phase, "save_to_history");
+    for (int n = 1; n < BENCH_TREATMENTS; n++) {
+        fixture_make_record(&record, n);
+        storage_save_to_history(&record);
+        phase.ops++;
+    }
+    phase_end(&phase);
+    phase_report(&phase);
+    expect_reads(&phase, 150);
+
+    // Served from the page counts in RAM
+    phase_begin(&phase, "get_history_count");
+    for (int n = 0; n < BENCH_TREATMENTS; n++) {
+        storage_get_history_count();
+        phase.ops++;
+    }
+    phase_end(&phase);
+    phase_report(&phase);
+    expect_reads(&phase, 0);
+
+    // Steady-state capacity once the log is evicting
+    int stored = storage_get_history_count();
+    APP_LOG(APP_LOG_LEVEL_INFO, "  history holds %d treatments (%d weeks at %d/week)",
+            stored, stored / SESSIONS_PER_WEEK, SESSIONS_PER_WEEK);
+
+    // Single-record reads across the whole log
+    phase_begin(&phase, "load_from_history");
+    for (int i = 0; i < stored; i++) {
+        storage_load_from_history(i, &record);
+        phase.ops++;
+    }
+    phase_end(&phase);
+    phase_report(&phase);
+    expect_reads(&phase, 100);
+
+    // Whole-log reads through the bulk API
+    TreatmentRecord *all = malloc(stored * sizeof(TreatmentRecord));
+    if (all) {
+        phase_begin(&phase, "load_history_range");
+        for (int n = 0; n < 10; n++) {
+            storage_load_history_range(0, stored, all);
+            phase.ops++;
+        }
+        phase_end(&phase);
+        phase_report(&phase);
+        expect_reads(&phase, HISTORY_LOG_MAX_PAGES * 100);
+        free(all);
+    }
+
+    // Opening a summary: kept in RAM since the appends above
+    HistoryStats stats;
+    phase_begin(&phase, "load_history_stats");
+    for (int n = 0; n < BENCH_TREATMENTS; n++) {
+        storage_load_history_stats(&stats);
+        phase.ops++;
+    }
+    phase_end(&phase);
+    phase_report(&phase);
+    expect_reads(&phase, 0);
+
+    range_benchmark(stored);
+    codec_benchmark();
+    log_benchmark();
+
+    reset();
+    storage_set_backend(storage_backend_persist());
+    storage_reset_stats();
+    return s_ok;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <pebble.h>
+#include "data/storage_backend.h"
+
+// Drive the storage layer through simulated treatments on a backend and
+// log latency, call counts and bytes written per operation. reset empties
+// the backend before and after. Returns false if a steady-state phase
+// regressed or a date-range query disagreed with the linear scan.
+bool storage_benchmark_run(const char *name, const StorageBackend *backend, void (*reset)(void));
@@ -0,0 +1,312 @@
+#include "storage_fault_test.h"
+#include "data/storage.h"
+#include "ui/render_scheduler.h"
+#include "fixture.h"
+
+#define FAULT_TREATMENTS     300     // Runs past the first eviction of the log
+#define FAULT_CHUNK          8       // Records per range read while verifying
+#define FAULT_RECOVERY_ROUNDS 100
+#define FAULT_SNAPSHOT_KEYS  (HISTORY_LOG_MAX_PAGES + 2)
+
+typedef enum {
+    FAULT_DROP,                 // The failing write never reaches flash
+    FAULT_TEAR,                 // Only its first half does. Persist writes
+                                // are atomic per key, so this only checks
+                                // that the page CRC catches the damage.
+    FAULT_MODE_COUNT
+} FaultMode;
+
+static const char *const s_mode_names[] = { "dropped", "torn" };
+
+static struct {
+    uint32_t writes;            // Mutating calls since the fault was armed
+    uint32_t fail_at;           // Call that loses power, 0 = never
+    FaultMode mode;
+    uint32_t trials;
+    uint32_t failures;
+    uint32_t torn_pages;        // Torn writes that cost committed records
+    uint32_t torn_records;      // Committed records those lost
+} s_fault;
+
+// Value of one key a history save can touch, for rolling back a trial
+typedef struct {
+    int16_t length;             // -1 if the key did not exist
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} KeySnapshot;
+
+// ---------------------------------------------------------------------------
+// Memory backend with a power cut at the fail_at-th mutating call
+// ---------------------------------------------------------------------------
+
+static const StorageBackend *memory(void) {
+    return storage_backend_memory();
+}
+
+// Count a mutating call; true once the power is gone
+static bool power_lost(void) {
+    if (s_fault.fail_at == 0) {
+        return false;
+    }
+    s_fault.writes++;
+    return s_fault.writes >= s_fault.fail_at;
+}
+
+static bool fault_exists(uint32_t key) {
+    return memory()->exists(key);
+}
+
+static int fault_read_data(uint32_t key, void *buffer, size_t size) {
+    return memory()->read_data(key, buffer, size);
+}
+
+static int fault_write_data(uint32_t key, const void *data, size_t size) {
+    if (!power_lost()) {
+        return memory()->write_data(key, data, size);
+    }
+    if (s_fault.writes == s_fault.fail_at && s_fault.mode == FAULT_TEAR) {
+        memory()->write_data(key, data, size / 2);
+    }
+    return E_ERROR;
+}
+
+static int32_t fault_read_int(uint32_t key) {
+    return memory()->read_int(key);
+}
+
+static status_t fault_write_int(uint32_t key, int32_t value) {
+    return power_lost() ? E_ERROR : memory()->write_int(key, value);
+}
+
+static status_t fault_remove(uint32_t key) {
+    return power_lost() ? E_ERROR : memory()->remove(key);
+}
+
+static const StorageBackend s_fault_backend = {
+    .exists = fault_exists,
+    .read_data = fault_read_data,
+    .write_data = fault_write_data,
+    .read_int = fault_read_int,
+    .write_int = fault_write_int,
+    .remove = fault_remove
+};
+
+// Storage forgets everything it cached, as after a reset
+static void restart(void) {
+    storage_set_backend(&s_fault_backend);
+}
+
+static uint32_t snapshot_key(int i) {
+    if (i < HISTORY_LOG_MAX_PAGES) {
+        return STORAGE_KEY_LOG_PAGE_BASE + i;
+    }
+    return (i == HISTORY_LOG_MAX_PAGES) ? STORAGE_KEY_HISTORY_STATS : STORAGE_KEY_TREND;
+}
+
+static void take_snapshot(KeySnapshot *snapshot) {
+    for (int i = 0; i < FAULT_SNAPSHOT_KEYS; i++) {
+        uint32_t key = snapshot_key(i);
+        snapshot[i].length = memory()->exists(key) ?
+            memory()->read_data(key, snapshot[i].data, sizeof(snapshot[i].data)) : -1;
+    }
+}
+
+static void restore_snapshot(const KeySnapshot *snapshot) {
+    for (int i = 0; i < FAULT_SNAPSHOT_KEYS; i++) {
+        uint32_t key = snapshot_key(i);
+        if (snapshot[i].length < 0) {
+            memory()->remove(key);
+        } else {
+            memory()->write_data(key, snapshot[i].data, snapshot[i].length);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Checks
+// ---------------------------------------------------------------------------
+
+// The log must hold exactly the records [next_seq - count, next_seq), and
+// the statistics and trend must describe the same records. Returns NULL
+// if consistent, else what is wrong.
+static const char *verify_log(void) {
+    int count = storage_get_history_count();
+    uint32_t next_seq = storage_get_history_next_seq();
+    uint32_t seq = next_seq - count;
+    TreatmentRecord chunk[FAULT_CHUNK];
+    TreatmentRecord expected;
+    HistoryStats expected_stats;
+    HistoryStats stats;
+
+    history_stats_init(&expected_stats);
+    for (int i = 0; i < count; i += FAULT_CHUNK) {
+        int n = storage_load_history_range(i, FAULT_CHUNK, chunk);
+        if (n != MIN(FAULT_CHUNK, count - i)) {
+            return "short read";
+        }
+        for (int k = 0; k < n; k++, seq++) {
+            fixture_make_record(&expected, seq);
+            if (!treatment_records_equal(&chunk[k], &expected)) {
+                return "wrong record";
+            }
+            history_stats_add(&expected_stats, &chunk[k]);
+        }
+    }
+
+    storage_load_history_stats(&stats);
+    if (memcmp(&stats, &expected_stats, sizeof(stats)) != 0) {
+        return "stats differ from log";
+    }
+
+    const TrendState *trend = storage_get_trend();
+    if (trend->samples < count || trend->samples > next_seq) {
+        return "trend sample count";
+    }
+    if (count > 0 && trend->last_post != expected.post_weight) {
+        return "trend behind log";
+    }
+    return NULL;
+}
+
+// Save treatment seq with the power cut at mutating call fail_at, restart,
+// check, then save it again as the app would when resuming it. The store
+// is rolled back afterwards. Returns false if the save needed fewer calls
+// than fail_at (no later cut point exists).
+static bool run_trial(uint32_t seq, uint32_t fail_at, FaultMode mode, KeySnapshot *snapshot) {
+    TreatmentRecord record;
+    uint32_t old_seq = storage_get_history_next_seq();
+    int old_count = storage_get_history_count();
+    const char *failure = NULL;
+
+    fixture_make_record(&record, seq);
+    take_snapshot(snapshot);
+
+    s_fault.writes = 0;
+    s_fault.fail_at = fail_at;
+    s_fault.mode = mode;
+    storage_save_to_history(&record);
+    bool cut = s_fault.writes >= fail_at;
+    s_fault.fail_at = 0;
+
+    restart();
+    uint32_t next_seq = storage_get_history_next_seq();
+    int count = storage_get_history_count();
+    bool lost = next_seq <= old_seq && count < old_count;
+    if (next_seq > old_seq + 1) {
+        failure = "sequence jumped";
+    } else if (lost && mode == FAULT_DROP) {
+        failure = "committed records lost";
+    } else if (next_seq == old_seq && count > old_count) {
+        failure = "uncommitted save changed the log";
+    } else {
+        failure = verify_log();
+    }
+
+    if (!failure && lost) {
+        // A torn page was rejected; what is left must still be consistent
+        s_fault.torn_pages++;
+        s_fault.torn_records += old_count - count;
+    } else if (!failure) {
+        storage_save_to_history(&record);
+        failure = (storage_get_history_next_seq() != old_seq + 1) ?
+                  "resumed save duplicated or lost" : verify_log();
+    }
+
+    s_fault.trials++;
+    if (failure) {
+        s_fault.failures++;
+        APP_LOG(APP_LOG_LEVEL_WARNING, "fault test: seq %ld, call %ld %s: %s",
+                (long)seq, (long)fail_at, s_mode_names[mode], failure);
+    }
+
+    restore_snapshot(snapshot);
+    restart();
+    return cut;
+}
+
+// ---------------------------------------------------------------------------
+// Recovery cost
+// ---------------------------------------------------------------------------
+
+static void log_recovery(const char *name) {
+    int count = 0;
+    storage_reset_stats();
+    uint32_t start = render_clock_ms();
+    for (int n = 0; n < FAULT_RECOVERY_ROUNDS; n++) {
+        restart();
+        count = storage_get_history_count();
+    }
+    uint32_t elapsed = render_clock_ms() - start;
+    const StorageStats *stats = storage_get_stats();
+    APP_LOG(APP_LOG_LEVEL_INFO, "fault test recovery (%s): %d records, %ld reads, %ld bytes, %ld us",
+            name, count,
+            (long)(stats->read_calls / FAULT_RECOVERY_ROUNDS),
+            (long)(stats->bytes_read / FAULT_RECOVERY_ROUNDS),
+            (long)((elapsed * 1000) / FAULT_RECOVERY_ROUNDS));
+}
+
+// Restart cost with a full log, then with the newest page damaged so
+// recovery has to fall back to the page before it
+static void recovery_benchmark(KeySnapshot *buffer) {
+    log_recovery("clean");
+
+    int tail = -1;
+    uint32_t tail_seq = 0;
+    for (int slot = 0; slot < HISTORY_LOG_MAX_PAGES; slot++) {
+        uint32_t first_seq;
+        uint8_t count;
+        int bytes = memory()->read_data(STORAGE_KEY_LOG_PAGE_BASE + slot, buffer->data,
+                                        HISTORY_LOG_HEADER_SIZE);
+        if (history_log_header_decode(buffer->data, bytes, &first_seq, &count) &&
+            (tail < 0 || first_seq > tail_seq)) {
+            tail = slot;
+            tail_seq = first_seq;
+        }
+    }
+    if (tail < 0) {
+        return;
+    }
+
+    int length = memory()->read_data(STORAGE_KEY_LOG_PAGE_BASE + tail, buffer->data,
+                                     sizeof(buffer->data));
+    buffer->data[length - 1] ^= 0xFF;
+    memory()->write_data(STORAGE_KEY_LOG_PAGE_BASE + tail, buffer->data, length);
+    log_recovery("damaged tail");
+}
+
+bool storage_fault_test_run(void) {
+    KeySnapshot *snapshot = malloc(FAULT_SNAPSHOT_KEYS * sizeof(KeySnapshot));
+    if (!snapshot) {
+        return false;
+    }
+
+    memset(&s_fault, 0, sizeof(s_fault));
+    storage_backend_memory_reset();
+    restart();
+
+    uint32_t start = render_clock_ms();
+    for (uint32_t seq = 0; seq < FAULT_TREATMENTS; seq++) {
+        for (int mode = 0; mode < FAULT_MODE_COUNT; mode++) {
+            for (uint32_t fail_at = 1; run_trial(seq, fail_at, mode, snapshot); fail_at++) {
+            }
+        }
+
+        // Then commit it for real
+        TreatmentRecord record;
+        fixture_make_record(&record, seq);
+        storage_save_to_history(&record);
+    }
+    const char *failure = verify_log();
+    APP_LOG(APP_LOG_LEVEL_INFO, "fault test: %ld power cuts over %d saves, %ld failures, final log %s, %ld ms",
+            (long)s_fault.trials, FAULT_TREATMENTS, (long)s_fault.failures,
+            failure ? failure : "ok", (long)(render_clock_ms() - start));
+    APP_LOG(APP_LOG_LEVEL_INFO, "  torn writes: %ld damaged pages rejected, %ld committed records lost with them",
+            (long)s_fault.torn_pages, (long)s_fault.torn_records);
+
+    recovery_benchmark(snapshot);
+
+    free(snapshot);
+    storage_backend_memory_reset();
+    storage_set_backend(storage_backend_persist());
+    storage_reset_stats();
+    return s_fault.failures == 0 && !failure;
+}
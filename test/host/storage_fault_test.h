@@ -0,0 +1,13 @@
+#pragma once
+
+#include <pebble.h>
+
+// Cut the power at every write of a history save, on the memory backend:
+// the write is either dropped or torn, every later write is lost, and the
+// storage layer is restarted. Checks that each restart sees the log either
+// without or with the new treatment, never anything in between, that the
+// statistics and trend agree with it, and that saving the treatment again
+// does not duplicate it. Also logs the cost of recovering a full log whose
+// tail page is damaged. Restores the persist backend when done. Returns
+// false if any trial or the final log failed its checks.
+bool storage_fault_test_run(void);
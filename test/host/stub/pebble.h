@@ -0,0 +1,492 @@
+#pragma once
+
+// Stand-in for the Pebble SDK header, enough to build src/c on Linux. The
+// declarations follow the SDK; the behaviour lives in pebble_stub.c
+// (persist, time, timers, heap, AppMessage) and ui_stub.c (windows,
+// layers, clicks, drawing). Pick the platform with -DPBL_PLATFORM_<NAME>.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ---------------------------------------------------------------------------
+// Platform
+// ---------------------------------------------------------------------------
+
+#if defined(PBL_PLATFORM_APLITE) || defined(PBL_PLATFORM_DIORITE)
+#define PBL_BW
+#define PBL_RECT
+#elif defined(PBL_PLATFORM_CHALK)
+#define PBL_COLOR
+#define PBL_ROUND
+#else
+#define PBL_COLOR
+#define PBL_RECT
+#endif
+
+#ifdef PBL_COLOR
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#else
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+#endif
+
+#ifdef PBL_ROUND
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_true)
+#define STUB_DISPLAY_WIDTH   180
+#define STUB_DISPLAY_HEIGHT  180
+#else
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+#define STUB_DISPLAY_WIDTH   144
+#define STUB_DISPLAY_HEIGHT  168
+#endif
+
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+// ---------------------------------------------------------------------------
+// Status codes and logging
+// ---------------------------------------------------------------------------
+
+typedef int32_t status_t;
+
+#define S_SUCCESS              0
+#define E_ERROR               -1
+#define E_INVALID_ARGUMENT    -4
+#define E_OUT_OF_STORAGE      -6
+#define E_OUT_OF_RESOURCES    -7
+#define E_RANGE               -8
+#define E_DOES_NOT_EXIST      -9
+
+typedef enum {
+    APP_LOG_LEVEL_ERROR = 1,
+    APP_LOG_LEVEL_WARNING = 50,
+    APP_LOG_LEVEL_INFO = 100,
+    APP_LOG_LEVEL_DEBUG = 200,
+    APP_LOG_LEVEL_DEBUG_VERBOSE = 255
+} AppLogLevel;
+
+void app_log(uint8_t level, const char *file, int line, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// ---------------------------------------------------------------------------
+// Heap: app allocations are counted so heap_bytes_used() means something
+// ---------------------------------------------------------------------------
+
+void *stub_malloc(size_t size);
+void *stub_calloc(size_t count, size_t size);
+void *stub_realloc(void *ptr, size_t size);
+void stub_free(void *ptr);
+
+#define malloc(size) stub_malloc(size)
+#define calloc(count, size) stub_calloc(count, size)
+#define realloc(ptr, size) stub_realloc(ptr, size)
+#define free(ptr) stub_free(ptr)
+
+size_t heap_bytes_used(void);
+size_t heap_bytes_free(void);
+
+// ---------------------------------------------------------------------------
+// Persistent storage
+// ---------------------------------------------------------------------------
+
+#define PERSIST_DATA_MAX_LENGTH    256
+#define PERSIST_STRING_MAX_LENGTH  PERSIST_DATA_MAX_LENGTH
+
+bool persist_exists(uint32_t key);
+int32_t persist_read_int(uint32_t key);
+status_t persist_write_int(uint32_t key, int32_t value);
+int persist_read_data(uint32_t key, void *buffer, size_t buffer_size);
+int persist_write_data(uint32_t key, const void *data, size_t size);
+status_t persist_delete(uint32_t key);
+
+// ---------------------------------------------------------------------------
+// Time, timers and services
+// ---------------------------------------------------------------------------
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer);
+
+// Runs timers until none are left
+void app_event_loop(void);
+
+typedef enum {
+    SECOND_UNIT = 1 << 0,
+    MINUTE_UNIT = 1 << 1,
+    HOUR_UNIT = 1 << 2,
+    DAY_UNIT = 1 << 3,
+    MONTH_UNIT = 1 << 4,
+    YEAR_UNIT = 1 << 5
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef int32_t WakeupId;
+typedef void (*WakeupHandler)(WakeupId wakeup_id, int32_t cookie);
+
+WakeupId wakeup_schedule(time_t timestamp, int32_t cookie, bool notify_if_missed);
+void wakeup_cancel(WakeupId wakeup_id);
+void wakeup_cancel_all(void);
+bool wakeup_query(WakeupId wakeup_id, time_t *timestamp);
+void wakeup_service_subscribe(WakeupHandler handler);
+bool wakeup_get_launch_event(WakeupId *wakeup_id, int32_t *cookie);
+
+typedef enum {
+    APP_LAUNCH_SYSTEM,
+    APP_LAUNCH_USER,
+    APP_LAUNCH_PHONE,
+    APP_LAUNCH_WAKEUP
+} AppLaunchReason;
+
+AppLaunchReason launch_reason(void);
+
+void vibes_short_pulse(void);
+void vibes_long_pulse(void);
+void vibes_double_pulse(void);
+
+// ---------------------------------------------------------------------------
+// AppMessage
+// ---------------------------------------------------------------------------
+
+typedef struct DictionaryIterator DictionaryIterator;
+
+typedef enum {
+    TUPLE_BYTE_ARRAY = 0,
+    TUPLE_CSTRING = 1,
+    TUPLE_UINT = 2,
+    TUPLE_INT = 3
+} TupleType;
+
+typedef struct __attribute__((__packed__)) {
+    uint32_t key;
+    TupleType type:8;
+    uint16_t length;
+    // Sized to the largest length rather than the SDK's [0], which newer
+    // host compilers reject when indexed; tuples are only used by pointer
+    union {
+        uint8_t data[UINT16_MAX];
+        char cstring[UINT16_MAX];
+        uint8_t uint8;
+        uint16_t uint16;
+        uint32_t uint32;
+        int8_t int8;
+        int16_t int16;
+        int32_t int32;
+    } value[];
+} Tuple;
+
+typedef struct {
+    TupleType type;
+    uint32_t key;
+    union {
+        struct {
+            const uint8_t *data;
+            uint16_t length;
+        } bytes;
+        struct {
+            const char *data;
+            uint16_t length;
+        } cstring;
+        struct {
+            uint32_t storage;
+            uint16_t width;
+        } integer;
+    };
+} Tuplet;
+
+#define TupletBytes(_key, _data, _length) \
+    ((const Tuplet) { .type = TUPLE_BYTE_ARRAY, .key = (_key), \
+                      .bytes = { .data = (_data), .length = (_length) } })
+#define TupletInteger(_key, _integer) \
+    ((const Tuplet) { .type = TUPLE_INT, .key = (_key), \
+                      .integer = { .storage = (uint32_t)(_integer), .width = sizeof(_integer) } })
+
+typedef enum {
+    DICT_OK = 0,
+    DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+    DICT_INVALID_ARGS = 1 << 2
+} DictionaryResult;
+
+typedef enum {
+    APP_MSG_OK = 0,
+    APP_MSG_SEND_TIMEOUT = 1 << 1,
+    APP_MSG_SEND_REJECTED = 1 << 2,
+    APP_MSG_NOT_CONNECTED = 1 << 3,
+    APP_MSG_BUSY = 1 << 6,
+    APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+    APP_MSG_INVALID_STATE = 1 << 13
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason,
+                                       void *context);
+
+AppMessageResult app_message_open(uint32_t size_inbound, uint32_t size_outbound);
+uint32_t app_message_inbox_size_maximum(void);
+uint32_t app_message_outbox_size_maximum(void);
+void app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+void app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+void app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+void app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+void app_message_deregister_callbacks(void);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, uint32_t key, const uint8_t *data,
+                                 uint16_t size);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, uint32_t key, int32_t value);
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, uint32_t key, uint32_t value);
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, uint32_t key, uint8_t value);
+Tuple *dict_find(const DictionaryIterator *iter, uint32_t key);
+uint32_t dict_calc_buffered_size_from_tuplets(const Tuplet * const tuplets, const uint8_t tuplets_count);
+
+// Generated from package.json messageKeys by the SDK
+extern uint32_t MESSAGE_KEY_ExportRequest;
+extern uint32_t MESSAGE_KEY_ExportSeq;
+extern uint32_t MESSAGE_KEY_ExportTotal;
+extern uint32_t MESSAGE_KEY_ExportRecords;
+extern uint32_t MESSAGE_KEY_ExportFirstSeq;
+extern uint32_t MESSAGE_KEY_SyncSince;
+extern uint32_t MESSAGE_KEY_ImportRecords;
+extern uint32_t MESSAGE_KEY_ImportFirstSeq;
+extern uint32_t MESSAGE_KEY_TraceDump;
+
+// ---------------------------------------------------------------------------
+// Graphics
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+} GPoint;
+
+typedef struct {
+    int16_t w;
+    int16_t h;
+} GSize;
+
+typedef struct {
+    GPoint origin;
+    GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){ (x), (y) })
+#define GSize(w, h) ((GSize){ (w), (h) })
+#define GRect(x, y, w, h) ((GRect){ { (x), (y) }, { (w), (h) } })
+#define GRectZero GRect(0, 0, 0, 0)
+
+typedef union {
+    uint8_t argb;
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define GColorClear        ((GColor8){ .argb = 0x00 })
+#define GColorBlack        ((GColor8){ .argb = 0xC0 })
+#define GColorDarkGreen    ((GColor8){ .argb = 0xC4 })
+#define GColorCobaltBlue   ((GColor8){ .argb = 0xC6 })
+#define GColorJaegerGreen  ((GColor8){ .argb = 0xD9 })
+#define GColorLightGray    ((GColor8){ .argb = 0xEA })
+#define GColorRed          ((GColor8){ .argb = 0xF0 })
+#define GColorWhite        ((GColor8){ .argb = 0xFF })
+
+static inline bool gcolor_equal(GColor8 x, GColor8 y) {
+    return x.argb == y.argb;
+}
+
+typedef enum {
+    GCornerNone = 0,
+    GCornersAll = 0xF
+} GCornerMask;
+
+typedef enum {
+    GTextAlignmentLeft,
+    GTextAlignmentCenter,
+    GTextAlignmentRight
+} GTextAlignment;
+
+typedef enum {
+    GTextOverflowModeWordWrap,
+    GTextOverflowModeTrailingEllipsis,
+    GTextOverflowModeFill
+} GTextOverflowMode;
+
+typedef struct GContext GContext;
+typedef struct GTextAttributes GTextAttributes;
+typedef struct GFontStub *GFont;
+
+#define FONT_KEY_GOTHIC_14       "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_18       "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD  "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24       "RESOURCE_ID_GOTHIC_24"
+#define FONT_KEY_GOTHIC_24_BOLD  "RESOURCE_ID_GOTHIC_24_BOLD"
+#define FONT_KEY_GOTHIC_28_BOLD  "RESOURCE_ID_GOTHIC_28_BOLD"
+
+GFont fonts_get_system_font(const char *font_key);
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_draw_text(GContext *ctx, const char *text, const GFont font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes);
+
+// ---------------------------------------------------------------------------
+// Layers and windows
+// ---------------------------------------------------------------------------
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef struct TextLayer TextLayer;
+typedef struct MenuLayer MenuLayer;
+
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer *layer_create(GRect frame);
+Layer *layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer *layer);
+void *layer_get_data(const Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_set_hidden(Layer *layer, bool hidden);
+GRect layer_get_bounds(const Layer *layer);
+GRect layer_get_frame(const Layer *layer);
+
+TextLayer *text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer *text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+
+typedef enum {
+    BUTTON_ID_BACK,
+    BUTTON_ID_UP,
+    BUTTON_ID_SELECT,
+    BUTTON_ID_DOWN,
+    NUM_BUTTONS
+} ButtonId;
+
+typedef void *ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+
+ButtonId click_recognizer_get_button_id(ClickRecognizerRef recognizer);
+bool click_recognizer_is_repeating(ClickRecognizerRef recognizer);
+uint8_t click_number_of_clicks_counted(ClickRecognizerRef recognizer);
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms,
+                                             ClickHandler handler);
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler,
+                                 ClickHandler up_handler);
+
+typedef void (*WindowHandler)(Window *window);
+
+typedef struct {
+    WindowHandler load;
+    WindowHandler appear;
+    WindowHandler disappear;
+    WindowHandler unload;
+} WindowHandlers;
+
+Window *window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_click_config_provider_with_context(Window *window,
+                                                   ClickConfigProvider click_config_provider,
+                                                   void *context);
+void window_set_user_data(Window *window, void *data);
+void *window_get_user_data(const Window *window);
+Layer *window_get_root_layer(const Window *window);
+void window_set_background_color(Window *window, GColor background_color);
+
+void window_stack_push(Window *window, bool animated);
+Window *window_stack_pop(bool animated);
+void window_stack_pop_all(const bool animated);
+bool window_stack_remove(Window *window, bool animated);
+bool window_stack_contains_window(Window *window);
+Window *window_stack_get_top_window(void);
+
+// ---------------------------------------------------------------------------
+// MenuLayer
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint16_t section;
+    uint16_t row;
+} MenuIndex;
+
+typedef enum {
+    MenuRowAlignNone,
+    MenuRowAlignCenter,
+    MenuRowAlignTop,
+    MenuRowAlignBottom
+} MenuRowAlign;
+
+#define MENU_CELL_BASIC_HEADER_HEIGHT 16
+
+typedef uint16_t (*MenuLayerGetNumberOfSectionsCallback)(MenuLayer *menu_layer, void *context);
+typedef uint16_t (*MenuLayerGetNumberOfRowsInSectionsCallback)(MenuLayer *menu_layer,
+                                                               uint16_t section_index,
+                                                               void *context);
+typedef int16_t (*MenuLayerGetCellHeightCallback)(MenuLayer *menu_layer, MenuIndex *cell_index,
+                                                  void *context);
+typedef int16_t (*MenuLayerGetHeaderHeightCallback)(MenuLayer *menu_layer, uint16_t section_index,
+                                                    void *context);
+typedef void (*MenuLayerDrawRowCallback)(GContext *ctx, const Layer *cell_layer,
+                                         MenuIndex *cell_index, void *context);
+typedef void (*MenuLayerDrawHeaderCallback)(GContext *ctx, const Layer *cell_layer,
+                                            uint16_t section_index, void *context);
+typedef void (*MenuLayerSelectCallback)(MenuLayer *menu_layer, MenuIndex *cell_index,
+                                        void *context);
+typedef void (*MenuLayerSelectionChangedCallback)(MenuLayer *menu_layer, MenuIndex new_index,
+                                                  MenuIndex old_index, void *context);
+
+typedef struct {
+    MenuLayerGetNumberOfSectionsCallback get_num_sections;
+    MenuLayerGetNumberOfRowsInSectionsCallback get_num_rows;
+    MenuLayerGetCellHeightCallback get_cell_height;
+    MenuLayerGetHeaderHeightCallback get_header_height;
+    MenuLayerDrawRowCallback draw_row;
+    MenuLayerDrawHeaderCallback draw_header;
+    MenuLayerSelectCallback select_click;
+    MenuLayerSelectCallback select_long_click;
+    MenuLayerSelectionChangedCallback selection_changed;
+} MenuLayerCallbacks;
+
+MenuLayer *menu_layer_create(GRect frame);
+void menu_layer_destroy(MenuLayer *menu_layer);
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer);
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *callback_context,
+                              MenuLayerCallbacks callbacks);
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window);
+void menu_layer_reload_data(MenuLayer *menu_layer);
+void menu_layer_set_selected_index(MenuLayer *menu_layer, MenuIndex index, MenuRowAlign scroll_align,
+                                   bool animated);
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground);
+void menu_cell_basic_draw(GContext *ctx, const Layer *cell_layer, const char *title,
+                          const char *subtitle, void *icon);
+void menu_cell_basic_header_draw(GContext *ctx, const Layer *cell_layer, const char *title);
@@ -0,0 +1,453 @@
+// Non-UI half of the stub SDK: logging, heap accounting, persist, time,
+// timers, services and AppMessage
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdarg.h>
+#include "stub.h"
+
+// The stub's own allocations go to the real heap
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+void app_log(uint8_t level, const char *file, int line, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    if (level <= APP_LOG_LEVEL_WARNING) {
+        const char *name = strrchr(file, '/');
+        printf("%s:%d: ", name ? name + 1 : file, line);
+    }
+    vprintf(fmt, args);
+    putchar('\n');
+    va_end(args);
+}
+
+static StubCounters s_counters;
+
+const StubCounters *stub_get_counters(void) {
+    return &s_counters;
+}
+
+// ---------------------------------------------------------------------------
+// Heap - each block carries its size so frees can be subtracted
+// ---------------------------------------------------------------------------
+
+#if defined(PBL_PLATFORM_APLITE)
+#define STUB_HEAP_BYTES  24576
+#else
+#define STUB_HEAP_BYTES  65536
+#endif
+
+typedef union {
+    size_t size;
+    long double align;
+} BlockHeader;
+
+static size_t s_heap_used;
+
+void *stub_malloc(size_t size) {
+    BlockHeader *block = malloc(sizeof(BlockHeader) + size);
+    if (!block) {
+        return NULL;
+    }
+    block->size = size;
+    s_heap_used += size;
+    return block + 1;
+}
+
+void *stub_calloc(size_t count, size_t size) {
+    void *ptr = stub_malloc(count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void stub_free(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    BlockHeader *block = (BlockHeader *)ptr - 1;
+    s_heap_used -= block->size;
+    free(block);
+}
+
+void *stub_realloc(void *ptr, size_t size) {
+    void *resized = stub_malloc(size);
+    if (resized && ptr) {
+        size_t old = ((BlockHeader *)ptr - 1)->size;
+        memcpy(resized, ptr, MIN(old, size));
+        stub_free(ptr);
+    }
+    return resized;
+}
+
+size_t heap_bytes_used(void) {
+    return s_heap_used;
+}
+
+size_t heap_bytes_free(void) {
+    return (s_heap_used < STUB_HEAP_BYTES) ? STUB_HEAP_BYTES - s_heap_used : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Persist - one table per process, like the app's persist file
+// ---------------------------------------------------------------------------
+
+#define STUB_PERSIST_MAX_KEYS  256
+
+typedef struct {
+    uint32_t key;
+    bool used;
+    uint16_t length;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+static PersistEntry s_persist[STUB_PERSIST_MAX_KEYS];
+
+static PersistEntry *persist_find(uint32_t key) {
+    for (int i = 0; i < STUB_PERSIST_MAX_KEYS; i++) {
+        if (s_persist[i].used && s_persist[i].key == key) {
+            return &s_persist[i];
+        }
+    }
+    return NULL;
+}
+
+void stub_persist_reset(void) {
+    memset(s_persist, 0, sizeof(s_persist));
+}
+
+bool persist_exists(uint32_t key) {
+    return persist_find(key) != NULL;
+}
+
+int persist_read_data(uint32_t key, void *buffer, size_t buffer_size) {
+    s_counters.persist_reads++;
+    PersistEntry *entry = persist_find(key);
+    if (!entry) {
+        return E_DOES_NOT_EXIST;
+    }
+    size_t n = MIN(buffer_size, entry->length);
+    memcpy(buffer, entry->data, n);
+    return (int)n;
+}
+
+int persist_write_data(uint32_t key, const void *data, size_t size) {
+    s_counters.persist_writes++;
+    PersistEntry *entry = persist_find(key);
+    for (int i = 0; !entry && i < STUB_PERSIST_MAX_KEYS; i++) {
+        if (!s_persist[i].used) {
+            entry = &s_persist[i];
+            entry->used = true;
+            entry->key = key;
+        }
+    }
+    if (!entry) {
+        return E_OUT_OF_STORAGE;
+    }
+    size = MIN(size, PERSIST_DATA_MAX_LENGTH);
+    memcpy(entry->data, data, size);
+    entry->length = (uint16_t)size;
+    return (int)size;
+}
+
+int32_t persist_read_int(uint32_t key) {
+    int32_t value = 0;
+    persist_read_data(key, &value, sizeof(value));
+    return value;
+}
+
+status_t persist_write_int(uint32_t key, int32_t value) {
+    int bytes = persist_write_data(key, &value, sizeof(value));
+    return (bytes == (int)sizeof(value)) ? S_SUCCESS : E_OUT_OF_STORAGE;
+}
+
+status_t persist_delete(uint32_t key) {
+    PersistEntry *entry = persist_find(key);
+    if (!entry) {
+        return E_DOES_NOT_EXIST;
+    }
+    entry->used = false;
+    return S_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Time and timers
+// ---------------------------------------------------------------------------
+
+#define STUB_MAX_TIMERS  32
+
+struct AppTimer {
+    bool used;
+    uint64_t due_ms;            // On the simulated clock
+    AppTimerCallback callback;
+    void *data;
+};
+
+static AppTimer s_timers[STUB_MAX_TIMERS];
+static uint64_t s_sim_ms;
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    uint64_t ms = (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000 + s_sim_ms;
+    if (tloc) {
+        *tloc = (time_t)(ms / 1000);
+    }
+    if (out_ms) {
+        *out_ms = (uint16_t)(ms % 1000);
+    }
+    return (uint16_t)(ms % 1000);
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    for (int i = 0; i < STUB_MAX_TIMERS; i++) {
+        if (!s_timers[i].used) {
+            s_timers[i] = (AppTimer){
+                .used = true,
+                .due_ms = s_sim_ms + timeout_ms,
+                .callback = callback,
+                .data = callback_data
+            };
+            return &s_timers[i];
+        }
+    }
+    return NULL;
+}
+
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms) {
+    if (!timer || !timer->used) {
+        return false;
+    }
+    timer->due_ms = s_sim_ms + new_timeout_ms;
+    return true;
+}
+
+void app_timer_cancel(AppTimer *timer) {
+    if (timer) {
+        timer->used = false;
+    }
+}
+
+static AppTimer *next_timer(void) {
+    AppTimer *next = NULL;
+    for (int i = 0; i < STUB_MAX_TIMERS; i++) {
+        if (s_timers[i].used && (!next || s_timers[i].due_ms < next->due_ms)) {
+            next = &s_timers[i];
+        }
+    }
+    return next;
+}
+
+int stub_pending_timers(void) {
+    int pending = 0;
+    for (int i = 0; i < STUB_MAX_TIMERS; i++) {
+        pending += s_timers[i].used;
+    }
+    return pending;
+}
+
+void stub_run_timers(uint32_t ms) {
+    uint64_t until = s_sim_ms + ms;
+    AppTimer *timer;
+    while ((timer = next_timer()) && timer->due_ms <= until) {
+        if (timer->due_ms > s_sim_ms) {
+            s_sim_ms = timer->due_ms;
+        }
+        timer->used = false;
+        timer->callback(timer->data);
+        stub_render();
+    }
+    s_sim_ms = until;
+}
+
+void app_event_loop(void) {
+    AppTimer *timer;
+    while ((timer = next_timer())) {
+        stub_run_timers((uint32_t)(timer->due_ms - s_sim_ms));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Services
+// ---------------------------------------------------------------------------
+
+static TickHandler s_tick_handler;
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+    s_tick_handler = handler;
+}
+
+void tick_timer_service_unsubscribe(void) {
+    s_tick_handler = NULL;
+}
+
+static WakeupId s_next_wakeup = 1;
+static WakeupId s_wakeup;
+static time_t s_wakeup_time;
+
+WakeupId wakeup_schedule(time_t timestamp, int32_t cookie, bool notify_if_missed) {
+    s_wakeup = s_next_wakeup++;
+    s_wakeup_time = timestamp;
+    return s_wakeup;
+}
+
+void wakeup_cancel(WakeupId wakeup_id) {
+    if (wakeup_id == s_wakeup) {
+        s_wakeup = 0;
+    }
+}
+
+void wakeup_cancel_all(void) {
+    s_wakeup = 0;
+}
+
+bool wakeup_query(WakeupId wakeup_id, time_t *timestamp) {
+    if (wakeup_id == 0 || wakeup_id != s_wakeup) {
+        return false;
+    }
+    if (timestamp) {
+        *timestamp = s_wakeup_time;
+    }
+    return true;
+}
+
+void wakeup_service_subscribe(WakeupHandler handler) {
+}
+
+bool wakeup_get_launch_event(WakeupId *wakeup_id, int32_t *cookie) {
+    return false;
+}
+
+AppLaunchReason launch_reason(void) {
+    return APP_LAUNCH_USER;
+}
+
+void vibes_short_pulse(void) {
+    s_counters.vibes++;
+}
+
+void vibes_long_pulse(void) {
+    s_counters.vibes++;
+}
+
+void vibes_double_pulse(void) {
+    s_counters.vibes++;
+}
+
+// ---------------------------------------------------------------------------
+// AppMessage - the outbox is sized like the watch's, so a message that
+// would not fit fails here too; nothing is delivered
+// ---------------------------------------------------------------------------
+
+uint32_t MESSAGE_KEY_ExportRequest = 10000;
+uint32_t MESSAGE_KEY_ExportSeq = 10001;
+uint32_t MESSAGE_KEY_ExportTotal = 10002;
+uint32_t MESSAGE_KEY_ExportRecords = 10003;
+uint32_t MESSAGE_KEY_ExportFirstSeq = 10004;
+uint32_t MESSAGE_KEY_SyncSince = 10005;
+uint32_t MESSAGE_KEY_ImportRecords = 10006;
+uint32_t MESSAGE_KEY_ImportFirstSeq = 10007;
+uint32_t MESSAGE_KEY_TraceDump = 10008;
+
+#define STUB_OUTBOX_MAX  656
+#define DICT_HEADER      1          // Tuple count
+#define TUPLE_HEADER     7          // Key, type, length
+
+struct DictionaryIterator {
+    uint32_t size;
+    uint32_t used;
+};
+
+static DictionaryIterator s_outbox;
+static uint32_t s_outbox_size;
+static bool s_outbox_open;
+
+AppMessageResult app_message_open(uint32_t size_inbound, uint32_t size_outbound) {
+    s_outbox_size = size_outbound;
+    return APP_MSG_OK;
+}
+
+uint32_t app_message_inbox_size_maximum(void) {
+    return STUB_OUTBOX_MAX;
+}
+
+uint32_t app_message_outbox_size_maximum(void) {
+    return STUB_OUTBOX_MAX;
+}
+
+void app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+}
+
+void app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+}
+
+void app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+}
+
+void app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+}
+
+void app_message_deregister_callbacks(void) {
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+    if (s_outbox_open) {
+        return APP_MSG_BUSY;
+    }
+    s_outbox = (DictionaryIterator){ .size = s_outbox_size, .used = DICT_HEADER };
+    s_outbox_open = true;
+    *iterator = &s_outbox;
+    return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+    if (!s_outbox_open) {
+        return APP_MSG_INVALID_STATE;
+    }
+    s_outbox_open = false;
+    return APP_MSG_NOT_CONNECTED;
+}
+
+static DictionaryResult dict_reserve(DictionaryIterator *iter, uint32_t length) {
+    if (iter->used + TUPLE_HEADER + length > iter->size) {
+        return DICT_NOT_ENOUGH_STORAGE;
+    }
+    iter->used += TUPLE_HEADER + length;
+    return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, uint32_t key, const uint8_t *data,
+                                 uint16_t size) {
+    return dict_reserve(iter, size);
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, uint32_t key, int32_t value) {
+    return dict_reserve(iter, sizeof(value));
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator *iter, uint32_t key, uint32_t value) {
+    return dict_reserve(iter, sizeof(value));
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, uint32_t key, uint8_t value) {
+    return dict_reserve(iter, sizeof(value));
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, uint32_t key) {
+    return NULL;
+}
+
+uint32_t dict_calc_buffered_size_from_tuplets(const Tuplet * const tuplets, const uint8_t tuplets_count) {
+    uint32_t size = DICT_HEADER;
+    for (int i = 0; i < tuplets_count; i++) {
+        switch (tuplets[i].type) {
+            case TUPLE_BYTE_ARRAY: size += TUPLE_HEADER + tuplets[i].bytes.length;   break;
+            case TUPLE_CSTRING:    size += TUPLE_HEADER + tuplets[i].cstring.length; break;
+            default:               size += TUPLE_HEADER + tuplets[i].integer.width;  break;
+        }
+    }
+    return size;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <pebble.h>
+
+// Controls and counters of the stub SDK that only host suites use.
+
+// Simulated time. Timers run on a clock that only moves when a suite
+// advances it, so a 1.5 s write-behind or a 500 ms step costs nothing;
+// time_ms() reports the real clock plus the simulated offset.
+
+// Advance the clock by ms, running every timer that falls due on the way
+void stub_run_timers(uint32_t ms);
+int stub_pending_timers(void);
+
+// Watch flash: drop every key (the app's persist file)
+void stub_persist_reset(void);
+
+// Calls into the SDK since launch
+typedef struct {
+    uint32_t persist_writes;
+    uint32_t persist_reads;
+    uint32_t vibes;
+} StubCounters;
+
+const StubCounters *stub_get_counters(void);
+
+// Buttons. A window's click config provider runs when the window becomes
+// the top one and when its provider is set while on top, as on the watch,
+// and the subscriptions it makes are recorded per window.
+typedef enum {
+    STUB_PRESS_SINGLE,          // Click (or the first click of a held button)
+    STUB_PRESS_REPEAT,          // Auto-repeat of a held button
+    STUB_PRESS_LONG             // Long press, then release
+} StubPress;
+
+// Call the handler the top window subscribed for button and press, then
+// render. BACK with no handler pops the window. Returns false if nothing
+// is subscribed.
+bool stub_press(ButtonId button, StubPress press);
+
+// Run the update procs of the top window's layers if any layer was marked
+// dirty. Runs after every press and timer, like the firmware after events.
+void stub_render(void);
+
+// text_layer_set_text() and graphics_draw_text() calls since launch
+uint32_t stub_text_count(void);
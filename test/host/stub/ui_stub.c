@@ -0,0 +1,504 @@
+// UI half of the stub SDK: a window stack with the SDK's load/appear/
+// disappear/unload order, recorded click subscriptions, a layer tree whose
+// update procs run when something was marked dirty, and drawing that only
+// counts text. UI objects come from the counted heap, like on the watch.
+#include "stub.h"
+
+struct Layer {
+    GRect frame;
+    LayerUpdateProc update_proc;
+    bool hidden;
+    void *data;
+    Layer *parent;
+    Layer *first_child;
+    Layer *next_sibling;
+};
+
+struct TextLayer {
+    Layer layer;
+    const char *text;
+};
+
+struct MenuLayer {
+    Layer layer;
+    MenuLayerCallbacks callbacks;
+    void *context;
+};
+
+// What a window's click config provider subscribed for one button
+typedef struct {
+    ClickHandler single;
+    uint16_t repeat_interval_ms;    // 0 unless the single click repeats
+    ClickHandler long_down;
+    ClickHandler long_up;
+} ClickConfig;
+
+struct Window {
+    Layer root;
+    WindowHandlers handlers;
+    ClickConfigProvider click_config_provider;
+    void *click_context;
+    ClickConfig clicks[NUM_BUTTONS];
+    void *user_data;
+    bool loaded;
+};
+
+// What click_recognizer_*() report to a handler
+typedef struct {
+    ButtonId button;
+    bool repeating;
+} StubRecognizer;
+
+#define STUB_WINDOW_STACK_MAX  8
+
+static Window *s_stack[STUB_WINDOW_STACK_MAX];
+static int s_depth;
+static Window *s_configuring;       // Window whose provider is running
+static bool s_dirty;                // A layer was marked dirty since the last render
+static uint32_t s_text_count;
+
+// ---------------------------------------------------------------------------
+// Layers
+// ---------------------------------------------------------------------------
+
+static void layer_init(Layer *layer, GRect frame) {
+    memset(layer, 0, sizeof(*layer));
+    layer->frame = frame;
+}
+
+Layer *layer_create(GRect frame) {
+    return layer_create_with_data(frame, 0);
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+    Layer *layer = malloc(sizeof(Layer));
+    if (!layer) {
+        return NULL;
+    }
+    layer_init(layer, frame);
+    if (data_size > 0) {
+        layer->data = calloc(1, data_size);
+        if (!layer->data) {
+            free(layer);
+            return NULL;
+        }
+    }
+    return layer;
+}
+
+// Destroyed layers leave the tree, as in the SDK
+static void layer_unlink(Layer *layer) {
+    if (!layer->parent) {
+        return;
+    }
+    Layer **link = &layer->parent->first_child;
+    while (*link != layer) {
+        link = &(*link)->next_sibling;
+    }
+    *link = layer->next_sibling;
+    layer->parent = NULL;
+}
+
+void layer_destroy(Layer *layer) {
+    if (layer) {
+        layer_unlink(layer);
+        free(layer->data);
+        free(layer);
+    }
+}
+
+void *layer_get_data(const Layer *layer) {
+    return layer->data;
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+    layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer *layer) {
+    s_dirty = true;
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+    Layer **link = &parent->first_child;
+    while (*link) {
+        link = &(*link)->next_sibling;
+    }
+    *link = child;
+    child->parent = parent;
+    child->next_sibling = NULL;
+    s_dirty = true;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+    layer->hidden = hidden;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+    return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+GRect layer_get_frame(const Layer *layer) {
+    return layer->frame;
+}
+
+TextLayer *text_layer_create(GRect frame) {
+    TextLayer *text_layer = malloc(sizeof(TextLayer));
+    if (text_layer) {
+        layer_init(&text_layer->layer, frame);
+        text_layer->text = "";
+    }
+    return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+    if (text_layer) {
+        layer_unlink(&text_layer->layer);
+    }
+    free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+    return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+    text_layer->text = text;
+    s_text_count++;
+    s_dirty = true;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+}
+
+// ---------------------------------------------------------------------------
+// Drawing
+// ---------------------------------------------------------------------------
+
+GFont fonts_get_system_font(const char *font_key) {
+    return (GFont)font_key;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, const GFont font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+    s_text_count++;
+}
+
+uint32_t stub_text_count(void) {
+    return s_text_count;
+}
+
+static void render_layer(Layer *layer) {
+    if (layer->hidden) {
+        return;
+    }
+    if (layer->update_proc) {
+        layer->update_proc(layer, NULL);
+    }
+    for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+        render_layer(child);
+    }
+}
+
+void stub_render(void) {
+    if (!s_dirty || s_depth == 0) {
+        return;
+    }
+    s_dirty = false;
+    render_layer(&s_stack[s_depth - 1]->root);
+}
+
+// ---------------------------------------------------------------------------
+// Clicks
+// ---------------------------------------------------------------------------
+
+ButtonId click_recognizer_get_button_id(ClickRecognizerRef recognizer) {
+    return ((const StubRecognizer *)recognizer)->button;
+}
+
+bool click_recognizer_is_repeating(ClickRecognizerRef recognizer) {
+    return ((const StubRecognizer *)recognizer)->repeating;
+}
+
+uint8_t click_number_of_clicks_counted(ClickRecognizerRef recognizer) {
+    return 1;
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+    if (s_configuring) {
+        s_configuring->clicks[button_id].single = handler;
+        s_configuring->clicks[button_id].repeat_interval_ms = 0;
+    }
+}
+
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms,
+                                             ClickHandler handler) {
+    if (s_configuring) {
+        s_configuring->clicks[button_id].single = handler;
+        s_configuring->clicks[button_id].repeat_interval_ms = repeat_interval_ms;
+    }
+}
+
+void window_long_click_subscribe(ButtonId button_id, uint16_t delay_ms, ClickHandler down_handler,
+                                 ClickHandler up_handler) {
+    if (s_configuring) {
+        s_configuring->clicks[button_id].long_down = down_handler;
+        s_configuring->clicks[button_id].long_up = up_handler;
+    }
+}
+
+// Replace the window's subscriptions with what its provider makes now
+static void configure_clicks(Window *window) {
+    memset(window->clicks, 0, sizeof(window->clicks));
+    if (window->click_config_provider) {
+        s_configuring = window;
+        window->click_config_provider(window->click_context);
+        s_configuring = NULL;
+    }
+}
+
+bool stub_press(ButtonId button, StubPress press) {
+    if (s_depth == 0) {
+        return false;
+    }
+    Window *window = s_stack[s_depth - 1];
+    ClickConfig config = window->clicks[button];
+    StubRecognizer recognizer = { button, press == STUB_PRESS_REPEAT };
+    void *context = window->click_context ? window->click_context : window;
+
+    switch (press) {
+        case STUB_PRESS_SINGLE:
+            if (config.single) {
+                config.single(&recognizer, context);
+            } else if (button == BUTTON_ID_BACK) {
+                window_stack_pop(true);
+            } else {
+                return false;
+            }
+            break;
+        case STUB_PRESS_REPEAT:
+            if (!config.single || config.repeat_interval_ms == 0) {
+                return false;
+            }
+            config.single(&recognizer, context);
+            break;
+        default:
+            if (!config.long_down) {
+                return false;
+            }
+            config.long_down(&recognizer, context);
+            if (config.long_up) {
+                config.long_up(&recognizer, context);
+            }
+            break;
+    }
+    stub_render();
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Windows
+// ---------------------------------------------------------------------------
+
+Window *window_create(void) {
+    Window *window = calloc(1, sizeof(Window));
+    if (window) {
+        layer_init(&window->root, GRect(0, 0, STUB_DISPLAY_WIDTH, STUB_DISPLAY_HEIGHT));
+    }
+    return window;
+}
+
+void window_destroy(Window *window) {
+    free(window);
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+    window->handlers = handlers;
+}
+
+void window_set_click_config_provider_with_context(Window *window,
+                                                   ClickConfigProvider click_config_provider,
+                                                   void *context) {
+    window->click_config_provider = click_config_provider;
+    window->click_context = context;
+    if (s_depth > 0 && s_stack[s_depth - 1] == window) {
+        configure_clicks(window);
+    }
+}
+
+void window_set_user_data(Window *window, void *data) {
+    window->user_data = data;
+}
+
+void *window_get_user_data(const Window *window) {
+    return window->user_data;
+}
+
+Layer *window_get_root_layer(const Window *window) {
+    return (Layer *)&window->root;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+}
+
+// Becoming the top window: new click subscriptions and a full frame
+static void window_appear(Window *window) {
+    configure_clicks(window);
+    s_dirty = true;
+    if (window->handlers.appear) {
+        window->handlers.appear(window);
+    }
+}
+
+static void window_disappear(Window *window) {
+    if (window->handlers.disappear) {
+        window->handlers.disappear(window);
+    }
+}
+
+void window_stack_push(Window *window, bool animated) {
+    if (s_depth == STUB_WINDOW_STACK_MAX) {
+        return;
+    }
+    if (s_depth > 0) {
+        window_disappear(s_stack[s_depth - 1]);
+    }
+    s_stack[s_depth++] = window;
+    if (!window->loaded) {
+        window->loaded = true;
+        if (window->handlers.load) {
+            window->handlers.load(window);
+        }
+    }
+    window_appear(window);
+}
+
+static void remove_at(int index) {
+    Window *window = s_stack[index];
+    bool was_top = index == s_depth - 1;
+    memmove(&s_stack[index], &s_stack[index + 1], (s_depth - index - 1) * sizeof(Window *));
+    s_depth--;
+
+    if (was_top) {
+        window_disappear(window);
+    }
+    window->loaded = false;
+    if (window->handlers.unload) {
+        window->handlers.unload(window);
+    }
+    if (was_top && s_depth > 0) {
+        window_appear(s_stack[s_depth - 1]);
+    }
+}
+
+Window *window_stack_pop(bool animated) {
+    if (s_depth == 0) {
+        return NULL;
+    }
+    Window *window = s_stack[s_depth - 1];
+    remove_at(s_depth - 1);
+    return window;
+}
+
+void window_stack_pop_all(const bool animated) {
+    while (s_depth > 0) {
+        window_stack_pop(animated);
+    }
+}
+
+bool window_stack_remove(Window *window, bool animated) {
+    for (int i = 0; i < s_depth; i++) {
+        if (s_stack[i] == window) {
+            remove_at(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool window_stack_contains_window(Window *window) {
+    for (int i = 0; i < s_depth; i++) {
+        if (s_stack[i] == window) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Window *window_stack_get_top_window(void) {
+    return (s_depth > 0) ? s_stack[s_depth - 1] : NULL;
+}
+
+// ---------------------------------------------------------------------------
+// MenuLayer
+// ---------------------------------------------------------------------------
+
+MenuLayer *menu_layer_create(GRect frame) {
+    MenuLayer *menu_layer = calloc(1, sizeof(MenuLayer));
+    if (menu_layer) {
+        layer_init(&menu_layer->layer, frame);
+    }
+    return menu_layer;
+}
+
+void menu_layer_destroy(MenuLayer *menu_layer) {
+    if (menu_layer) {
+        layer_unlink(&menu_layer->layer);
+    }
+    free(menu_layer);
+}
+
+Layer *menu_layer_get_layer(const MenuLayer *menu_layer) {
+    return (Layer *)&menu_layer->layer;
+}
+
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *callback_context,
+                              MenuLayerCallbacks callbacks) {
+    menu_layer->callbacks = callbacks;
+    menu_layer->context = callback_context;
+}
+
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window) {
+}
+
+void menu_layer_reload_data(MenuLayer *menu_layer) {
+}
+
+void menu_layer_set_selected_index(MenuLayer *menu_layer, MenuIndex index, MenuRowAlign scroll_align,
+                                   bool animated) {
+}
+
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground) {
+}
+
+void menu_cell_basic_draw(GContext *ctx, const Layer *cell_layer, const char *title,
+                          const char *subtitle, void *icon) {
+}
+
+void menu_cell_basic_header_draw(GContext *ctx, const Layer *cell_layer, const char *title) {
+}
@@ -0,0 +1,350 @@
+#!/usr/bin/env node
+// Local stand-in for a phone/watch sync session. Runs src/pkjs/index.js
+// unchanged against a model of the watch side (sequence-numbered history
+// log, chunked export, imports and edits) and reports the bytes on the
+// wire per sync.
+//
+//   node tools/sync_standin.js
+//
+// Message sizes follow the Pebble dictionary format: a 1-byte tuple count,
+// then per tuple a 4-byte key, 1-byte type and 2-byte length before the
+// value. Integers are sent as 4 bytes.
+
+'use strict';
+
+var fs = require('fs');
+var path = require('path');
+var vm = require('vm');
+
+// Watch constants (src/c/comm/app_comm.h, src/c/data/storage.h)
+var INBOX_SIZE = 256;
+var OUTBOX_SIZE = 512;
+var RECORD_SIZE = 12;
+var IMPORT_MAX = 16;
+var LOG_PAGES = 8;
+var PAGE_RECORDS = 30;          // Typical delta-compressed records per page
+
+function dictBytes(dict) {
+  var bytes = 1;
+  Object.keys(dict).forEach(function(key) {
+    var value = dict[key];
+    bytes += 7 + (Array.isArray(value) ? value.length : 4);
+  });
+  return bytes;
+}
+
+// As app_comm_init(): whole records after every tuple of a chunk
+var CHUNK_RECORDS = Math.floor((OUTBOX_SIZE - dictBytes({
+  ExportSeq: 0, ExportTotal: 0, ExportFirstSeq: 0, ExportRecords: []
+})) / RECORD_SIZE);
+
+// ---------------------------------------------------------------------------
+// Link: messages are delivered in order, one task at a time
+// ---------------------------------------------------------------------------
+
+var tasks = [];
+var traffic = { up: 0, down: 0, messagesUp: 0, messagesDown: 0 };
+
+function post(task) {
+  tasks.push(task);
+}
+
+function runUntilIdle() {
+  while (tasks.length > 0) {
+    tasks.shift()();
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Watch model
+// ---------------------------------------------------------------------------
+
+function encode(record) {
+  var b = [1];
+  [record.pre, record.dry, record.post].forEach(function(v) { b.push(v & 0xFF, v >> 8); });
+  b.push((record.minutes / 15) | (record.delta ? 0x40 : 0) | 0x80);
+  var t = record.timestamp;
+  b.push(t & 0xFF, (t >>> 8) & 0xFF, (t >>> 16) & 0xFF, (t >>> 24) & 0xFF);
+  return b;
+}
+
+function timestampOf(bytes) {
+  return (bytes[8] | (bytes[9] << 8) | (bytes[10] << 16)) + bytes[11] * 0x1000000;
+}
+
+var watch = {
+  pages: [],                    // Arrays of encoded records, oldest first
+  nextSeq: 0,
+  exporting: false,
+  clock: 1700000000,
+
+  count: function() {
+    return this.pages.reduce(function(n, page) { return n + page.length; }, 0);
+  },
+
+  oldestSeq: function() {
+    return this.nextSeq - this.count();
+  },
+
+  append: function(bytes) {
+    var last = this.pages[this.pages.length - 1];
+    if (!last || last.length === PAGE_RECORDS) {
+      last = [];
+      this.pages.push(last);
+      if (this.pages.length > LOG_PAGES) {
+        this.pages.shift();
+      }
+    }
+    last.push(bytes);
+    this.nextSeq++;
+  },
+
+  newest: function() {
+    var last = this.pages[this.pages.length - 1];
+    return last ? timestampOf(last[last.length - 1]) : 0;
+  },
+
+  record: function(seq) {
+    var i = seq - this.oldestSeq();
+    for (var p = 0; p < this.pages.length; p++) {
+      if (i < this.pages[p].length) {
+        return { page: this.pages[p], offset: i };
+      }
+      i -= this.pages[p].length;
+    }
+    return null;
+  },
+
+  saveTreatment: function() {
+    this.clock += 2 * 86400 + 3600;
+    var n = this.nextSeq;
+    this.append(encode({
+      pre: 720 + (n % 30), dry: 700, post: 701 + (n % 5),
+      minutes: 240, delta: n % 2, timestamp: this.clock
+    }));
+  },
+
+  clear: function() {
+    this.pages = [];
+    this.nextSeq = 0;
+  },
+
+  // history_export_start(): one chunk per message, the next after the ACK
+  exportFrom: function(since) {
+    if (this.exporting) {
+      return;
+    }
+    var end = this.nextSeq;
+    if (since > end) {
+      since = 0;
+    }
+    var next = Math.max(since, this.oldestSeq());
+    var total = end - next;
+    var seq = 0;
+    var self = this;
+    self.exporting = true;
+
+    function sendChunk() {
+      var n = Math.min(CHUNK_RECORDS, end - next);
+      var dict = { ExportSeq: seq, ExportTotal: total, ExportFirstSeq: next };
+      if (n > 0) {
+        var bytes = [];
+        for (var i = 0; i < n; i++) {
+          var at = self.record(next + i);
+          bytes = bytes.concat(at.page[at.offset]);
+        }
+        dict.ExportRecords = bytes;
+      }
+      check(dictBytes(dict) <= OUTBOX_SIZE, 'chunk ' + seq + ' of ' + dictBytes(dict) +
+            ' bytes overflows the outbox');
+      traffic.down += dictBytes(dict);
+      traffic.messagesDown++;
+      post(function() {
+        phone.deliver(dict);
+        next += n;
+        seq++;
+        if (next >= end || n === 0) {
+          self.exporting = false;
+        } else {
+          sendChunk();
+        }
+      });
+    }
+    sendChunk();
+  },
+
+  // inbox_received_handler()
+  receive: function(dict) {
+    if (dict.ImportRecords) {
+      var records = [];
+      for (var i = 0; i + RECORD_SIZE <= dict.ImportRecords.length && records.length < IMPORT_MAX;
+           i += RECORD_SIZE) {
+        records.push(dict.ImportRecords.slice(i, i + RECORD_SIZE));
+      }
+      if (dict.ImportFirstSeq !== undefined) {
+        records.forEach(function(bytes, i) {
+          var at = this.record(dict.ImportFirstSeq + i);
+          if (at) {
+            at.page[at.offset] = bytes;
+          }
+        }, this);
+      } else {
+        records.forEach(function(bytes) {
+          if (timestampOf(bytes) > this.newest()) {
+            this.append(bytes);
+          }
+        }, this);
+      }
+    }
+    if (dict.ExportRequest) {
+      this.exportFrom(dict.SyncSince || 0);
+    }
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Phone: the real pkjs code with Pebble and localStorage stubbed
+// ---------------------------------------------------------------------------
+
+var listeners = {};
+var storage = {};
+var logs = [];
+
+var context = vm.createContext({
+  console: { log: function(line) { logs.push(line); } },
+  localStorage: {
+    getItem: function(key) { return storage.hasOwnProperty(key) ? storage[key] : null; },
+    setItem: function(key, value) { storage[key] = String(value); }
+  },
+  Pebble: {
+    addEventListener: function(name, fn) { listeners[name] = fn; },
+    sendAppMessage: function(dict, ack) {
+      check(dictBytes(dict) <= INBOX_SIZE, 'message of ' + dictBytes(dict) +
+            ' bytes overflows the watch inbox');
+      traffic.up += dictBytes(dict);
+      traffic.messagesUp++;
+      post(function() {
+        watch.receive(dict);
+        ack();
+      });
+    }
+  }
+});
+
+var source = fs.readFileSync(path.join(__dirname, '..', 'src', 'pkjs', 'index.js'), 'utf8');
+vm.runInContext(source, context, { filename: 'index.js' });
+
+var phone = {
+  deliver: function(dict) {
+    listeners.appmessage({ payload: dict });
+  },
+  history: function() {
+    return JSON.parse(storage.history || '[]');
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Scenarios
+// ---------------------------------------------------------------------------
+
+var failures = 0;
+
+function check(ok, what) {
+  if (!ok) {
+    console.log('  FAIL: ' + what);
+    failures++;
+  }
+}
+
+// The phone must hold every record the watch does, under the same seq
+function checkInSync() {
+  var bySeq = {};
+  phone.history().forEach(function(r) {
+    if (r.seq !== null) {
+      bySeq[r.seq] = r;
+    }
+  });
+  for (var seq = watch.oldestSeq(); seq < watch.nextSeq; seq++) {
+    var at = watch.record(seq);
+    var mine = bySeq[seq];
+    if (!mine || mine.timestamp !== timestampOf(at.page[at.offset]) ||
+        Math.round(mine.postWeight * 10) !== (at.page[at.offset][5] | (at.page[at.offset][6] << 8))) {
+      check(false, 'record ' + seq + ' differs');
+      return;
+    }
+  }
+}
+
+function sync(name, fullBytes) {
+  traffic = { up: 0, down: 0, messagesUp: 0, messagesDown: 0 };
+  listeners.ready();
+  runUntilIdle();
+  checkInSync();
+
+  var line = '  ' + name + ': ' + traffic.messagesUp + ' up / ' + traffic.messagesDown +
+             ' down messages, ' + traffic.up + ' + ' + traffic.down + ' bytes';
+  if (fullBytes) {
+    line += ' (full export: ' + fullBytes + ' bytes)';
+  }
+  console.log(line + ', watermark ' + storage.watermark + ', phone holds ' +
+              phone.history().length);
+}
+
+// Bytes of exporting the whole watch log, as before watermarks
+function fullExportBytes() {
+  var n = watch.count();
+  var bytes = 0;
+  do {
+    var chunk = Math.min(n, CHUNK_RECORDS);
+    bytes += dictBytes({ ExportSeq: 0, ExportTotal: 0, ExportFirstSeq: 0 }) +
+             (chunk > 0 ? 7 + chunk * RECORD_SIZE : 0);
+    n -= chunk;
+  } while (n > 0);
+  return bytes;
+}
+
+function treatments(n) {
+  for (var i = 0; i < n; i++) {
+    watch.saveTreatment();
+  }
+}
+
+console.log('Sync stand-in: ' + CHUNK_RECORDS + ' records per chunk, ~' +
+            LOG_PAGES * PAGE_RECORDS + ' records on the watch');
+
+treatments(100);
+sync('first sync, 100 records', fullExportBytes());
+
+treatments(3);
+sync('reconnect after 3 treatments', fullExportBytes());
+
+sync('reconnect, nothing new', fullExportBytes());
+
+treatments(400);
+sync('long gap, 400 treatments (older ones evicted)', fullExportBytes());
+
+var newest = watch.nextSeq - 1;
+check(context.editRecord(newest - 1, { postWeight: 69.5 }), 'edit accepted');
+check(context.editRecord(newest, { postWeight: 69.6 }), 'edit accepted');
+check(context.editRecord(newest - 20, { postWeight: 69.7 }), 'edit accepted');
+sync('3 edits (2 runs) sent after sync');
+var edited = watch.record(newest);
+check((edited.page[edited.offset][5] | (edited.page[edited.offset][6] << 8)) === 696,
+      'edit reached the watch');
+
+var held = phone.history().length;
+watch.clear();
+sync('watch reset, phone restores it');
+check(watch.count() >= Math.min(held, (LOG_PAGES - 1) * PAGE_RECORDS), 'watch restored');
+check(phone.history().length === held, 'no records lost or duplicated on the phone');
+
+treatments(2);
+sync('after restore, 2 treatments', fullExportBytes());
+
+watch.clear();
+treatments(300);
+sync('watch reset and 300 new treatments before reconnect');
+check(phone.history().length >= held, 'archived records kept on the phone');
+
+console.log(failures === 0 ? 'PASS' : failures + ' FAILED');
+process.exit(failures === 0 ? 0 : 1);